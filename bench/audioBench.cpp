@@ -0,0 +1,211 @@
+#include "audio.h"
+#include "benchmarks.h"
+#include "sampleConversion.h"
+#include "speech.h"
+#include "syntheticSpeechEngine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Rates SAPI voices are commonly installed with
+static constexpr ma_uint32 SAPI_SAMPLE_RATES[] = {8000, 11025, 16000, 22050, 44100};
+static constexpr int REPETITIONS = 5;
+static constexpr size_t RESAMPLER_INPUT_SECONDS = 10;
+static constexpr size_t CONVERSION_SAMPLE_COUNT = AUDIO_DEFAULT_SAMPLE_RATE * 2 * 10;
+// The null device plays everything queued in real time, so queued phrases stay in memory until the program exits
+static constexpr size_t QUEUED_PHRASES = 200;
+static constexpr size_t QUEUED_PHRASE_MILLISECONDS = 250;
+static constexpr size_t SPOKEN_PHRASES = 50;
+// Each probe waits until the device has played it, so the next one starts from an empty ring
+static constexpr size_t LATENCY_PROBES = 20;
+static constexpr size_t LATENCY_PROBE_MILLISECONDS = 20;
+
+static std::vector<ma_uint8> makeNoise(size_t sizeInBytes) {
+    std::vector<ma_uint8> noise(sizeInBytes);
+    std::mt19937 random(42);
+    std::generate(noise.begin(), noise.end(), [&] { return (ma_uint8)random(); });
+    return noise;
+}
+
+static void runResamplerBenchmarks() {
+    std::puts(std::format("CResampler, mono s16 to {} Hz, {} s of input, best of {} runs", AUDIO_DEFAULT_SAMPLE_RATE,
+                          RESAMPLER_INPUT_SECONDS, REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<12}{:>12}{:>20}", "rate Hz", "ms", "Mframes/s per core").c_str());
+    for (ma_uint32 sampleRate : SAPI_SAMPLE_RATES) {
+        const ma_uint64 frameCountIn = sampleRate * RESAMPLER_INPUT_SECONDS;
+        const std::vector<ma_uint8> input = makeNoise(frameCountIn * sizeof(int16_t));
+        CResampler resampler(ma_format_s16, 1, sampleRate, AUDIO_DEFAULT_SAMPLE_RATE);
+        ma_uint64 expectedFrameCount = 0;
+        ma_resampler_get_expected_output_frame_count(resampler, frameCountIn, &expectedFrameCount);
+        std::vector<int16_t> output(expectedFrameCount);
+        const double milliseconds = MeasureBestMilliseconds(
+            [&] {
+                ma_uint64 frameCountOut = output.size();
+                resampler.processAudioData(input.data(), frameCountIn, output.data(), frameCountOut);
+                ConsumeBenchmarkResult(output.data(), frameCountOut * sizeof(int16_t));
+            },
+            REPETITIONS);
+        const double framesPerMicrosecond = expectedFrameCount / milliseconds / 1000.0;
+        std::puts(std::format("{:<12}{:>12.3f}{:>20.1f}", sampleRate, milliseconds, framesPerMicrosecond).c_str());
+        RecordBenchmarkResult(std::format("cresampler/{}", sampleRate),
+                              {{"ms", milliseconds}, {"mframes_per_s", framesPerMicrosecond}});
+    }
+}
+
+static void runFormatConversionBenchmarks() {
+    std::puts(std::format("determineFormat and conversion to f32, {} samples, best of {} runs",
+                          CONVERSION_SAMPLE_COUNT, REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<12}{:>12}{:>14}", "bits", "ms", "Msamples/s").c_str());
+    std::vector<float> output(CONVERSION_SAMPLE_COUNT);
+    for (int bitsPerSample : {8, 16, 24, 32}) {
+        const std::vector<ma_uint8> input = makeNoise(CONVERSION_SAMPLE_COUNT * (bitsPerSample / 8));
+        const double milliseconds = MeasureBestMilliseconds(
+            [&] {
+                const ma_format format = determineFormat(bitsPerSample);
+                ConvertSamplesToF32(input.data(), format, output.data(), output.size(), 0.8f);
+                ConsumeBenchmarkResult(output.data(), output.size() * sizeof(float));
+            },
+            REPETITIONS);
+        const double samplesPerMicrosecond = CONVERSION_SAMPLE_COUNT / milliseconds / 1000.0;
+        std::puts(std::format("{:<12}{:>12.3f}{:>14.1f}", bitsPerSample, milliseconds, samplesPerMicrosecond).c_str());
+        RecordBenchmarkResult(std::format("format_conversion/{}", bitsPerSample),
+                              {{"ms", milliseconds}, {"msamples_per_s", samplesPerMicrosecond}});
+    }
+}
+
+static void printQueueResult(const std::string& name, double milliseconds, size_t phraseCount) {
+    const double microsecondsPerPhrase = milliseconds * 1000.0 / phraseCount;
+    const double phrasesPerSecond = phraseCount / milliseconds * 1000.0;
+    std::puts(std::format("{:<28}{:>16.2f}{:>14.0f}", name, microsecondsPerPhrase, phrasesPerSecond).c_str());
+    RecordBenchmarkResult(name, {{"us_per_phrase", microsecondsPerPhrase}, {"phrases_per_s", phrasesPerSecond}});
+}
+
+// Time from queueing a phrase to its first frame in the device callback, for each way of opening the device
+static void runDeviceLatencyBenchmarks() {
+    const std::pair<std::string, AudioDeviceConfig> deviceConfigs[] = {
+        {"default", {}},
+        {"low_latency", {.isLowLatency = true}},
+        {"low_latency/480x3", {.isLowLatency = true, .periodSizeInFrames = 480, .periods = 3}},
+        {"low_latency/128x2", {.isLowLatency = true, .periodSizeInFrames = 128, .periods = 2}},
+        {"low_latency/exclusive", {.isLowLatency = true, .isExclusive = true}},
+    };
+    const size_t probeFrameCount = AUDIO_DEFAULT_SAMPLE_RATE * LATENCY_PROBE_MILLISECONDS / 1000;
+    auto* pProbe = (int16_t*)malloc(probeFrameCount * sizeof(int16_t));
+    std::fill(pProbe, pProbe + probeFrameCount, INT16_MAX / 2);
+    auto probe = g_Audio.renderAudioData(1, AUDIO_DEFAULT_SAMPLE_RATE, 16, probeFrameCount * sizeof(int16_t), pProbe);
+    if (probe == nullptr) {
+        return;
+    }
+    std::puts(std::format("Output latency, {} probes of {} ms per device configuration", LATENCY_PROBES,
+                          LATENCY_PROBE_MILLISECONDS)
+                  .c_str());
+    std::puts(std::format("{:<28}{:>12}{:>12}{:>12}", "device", "buffer ms", "p50 ms", "p95 ms").c_str());
+    for (const auto& [name, deviceConfig] : deviceConfigs) {
+        g_Audio.setDeviceConfig(deviceConfig);
+        // Opens the device, so the probes do not include it
+        if (!g_Audio.queueRenderedSpeech(probe)) {
+            std::puts("No playback device, skipping the output latency benchmarks");
+            break;
+        }
+        g_Audio.waitUntilIdle();
+        const auto countsBefore = g_LatencyTracker.getCounts(LatencyStage::FirstFrame);
+        for (size_t i = 0; i < LATENCY_PROBES; ++i) {
+            g_Audio.queueRenderedSpeech(probe, LatencyClock::now());
+            g_Audio.waitUntilIdle();
+        }
+        auto counts = g_LatencyTracker.getCounts(LatencyStage::FirstFrame);
+        for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+            counts[bucket] -= countsBefore[bucket];
+        }
+        auto toMilliseconds = [](std::chrono::microseconds latency) {
+            return std::chrono::duration<double, std::milli>(latency).count();
+        };
+        const double bufferMilliseconds = toMilliseconds(g_Audio.getDeviceBufferLatency());
+        const double p50Milliseconds = toMilliseconds(LatencyHistogram::getPercentile(counts, 0.5));
+        const double p95Milliseconds = toMilliseconds(LatencyHistogram::getPercentile(counts, 0.95));
+        std::puts(std::format("{:<28}{:>12.1f}{:>12.1f}{:>12.1f}", name, bufferMilliseconds, p50Milliseconds,
+                              p95Milliseconds)
+                      .c_str());
+        RecordBenchmarkResult(
+            std::format("device_latency/{}", name),
+            {{"buffer_ms", bufferMilliseconds}, {"p50_ms", p50Milliseconds}, {"p95_ms", p95Milliseconds}});
+    }
+    g_Audio.setDeviceConfig({});
+}
+
+static void runQueueBenchmarks() {
+    // Opens the null device, so the measured calls do not include it
+    if (!g_Audio.playAudioData(1, AUDIO_DEFAULT_SAMPLE_RATE, 16, sizeof(int16_t), calloc(1, sizeof(int16_t)))) {
+        std::puts("No playback device, skipping the playback queue benchmarks");
+        return;
+    }
+    std::puts(std::format("Playback queue, mono s16 phrases of {} ms, {} per run, best of {} runs",
+                          QUEUED_PHRASE_MILLISECONDS, QUEUED_PHRASES, REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<28}{:>16}{:>14}", "path", "us per phrase", "phrases/s").c_str());
+
+    // Every phrase comes in its own malloc-allocated buffer like the ones SRAL returns, Audio takes them over
+    for (ma_uint32 sampleRate : {(ma_uint32)22050, AUDIO_DEFAULT_SAMPLE_RATE}) {
+        const std::vector<ma_uint8> phrase =
+            makeNoise(sampleRate * QUEUED_PHRASE_MILLISECONDS / 1000 * sizeof(int16_t));
+        std::vector<void*> buffers(QUEUED_PHRASES);
+        const double milliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (void*& pBuffer : buffers) {
+                    pBuffer = malloc(phrase.size());
+                    std::memcpy(pBuffer, phrase.data(), phrase.size());
+                }
+            },
+            [&] {
+                for (void* pBuffer : buffers) {
+                    g_Audio.playAudioData(1, (int)sampleRate, 16, phrase.size(), pBuffer);
+                }
+            },
+            REPETITIONS);
+        printQueueResult(std::format("play_audio_data/{}", sampleRate), milliseconds, QUEUED_PHRASES);
+    }
+
+    // Rendered speech from the cache is queued as is, so this is the cost of a playback payload alone
+    const size_t phraseSize = AUDIO_DEFAULT_SAMPLE_RATE * QUEUED_PHRASE_MILLISECONDS / 1000 * sizeof(int16_t);
+    auto speech = g_Audio.renderAudioData(1, AUDIO_DEFAULT_SAMPLE_RATE, 16, phraseSize, calloc(phraseSize, 1));
+    const double milliseconds = MeasureBestMilliseconds(
+        [&] {
+            for (size_t i = 0; i < QUEUED_PHRASES; ++i) {
+                g_Audio.queueRenderedSpeech(speech);
+            }
+        },
+        REPETITIONS);
+    printQueueResult("queue_rendered_speech", milliseconds, QUEUED_PHRASES);
+
+    // Synthesis, resampling and queueing of every phrase, with the memory cache disabled so nothing is reused
+    SyntheticSpeechConfig config;
+    Speech::GetInstance().setEngine(std::make_unique<SyntheticSpeechEngine>(config));
+    Speech::GetInstance().setCacheBudget(0);
+    size_t phraseNumber = 0;
+    const double speechMilliseconds = MeasureBestMilliseconds(
+        [&] {
+            for (size_t i = 0; i < SPOKEN_PHRASES; ++i) {
+                Speech::GetInstance().speak(std::format("Phrase {}", phraseNumber++).c_str());
+            }
+        },
+        REPETITIONS);
+    printQueueResult(std::format("speech/synthetic/{}", config.sampleRate), speechMilliseconds, SPOKEN_PHRASES);
+}
+
+void RunAudioBenchmarks() {
+    runResamplerBenchmarks();
+    runFormatConversionBenchmarks();
+    // Before the queue benchmarks, which leave minutes of audio queued
+    runDeviceLatencyBenchmarks();
+    runQueueBenchmarks();
+}
@@ -0,0 +1,126 @@
+#include "benchmarks.h"
+#include "sampleConversion.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+// Must follow windows.h
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+struct RecordedResult {
+    std::string name;
+    BenchmarkMetrics metrics;
+};
+
+static std::atomic<unsigned char> g_benchmarkSink;
+static std::vector<RecordedResult> g_recordedResults;
+static size_t g_failureCount = 0;
+
+void ConsumeBenchmarkResult(const void* pData, size_t size) {
+    if (size > 0) {
+        g_benchmarkSink.fetch_xor(((const unsigned char*)pData)[size - 1], std::memory_order_relaxed);
+    }
+}
+
+void RecordBenchmarkResult(const std::string& name, const BenchmarkMetrics& metrics) {
+    g_recordedResults.push_back({name, metrics});
+}
+
+void ReportBenchmarkFailure(const std::string& message) {
+    std::fprintf(stderr, "FAILED: %s\n", message.c_str());
+    ++g_failureCount;
+}
+
+size_t GetResidentMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    // The second field of statm is the resident size in pages
+    FILE* pFile = std::fopen("/proc/self/statm", "r");
+    if (pFile == nullptr) {
+        return 0;
+    }
+    unsigned long long totalPages = 0;
+    unsigned long long residentPages = 0;
+    const bool isRead = std::fscanf(pFile, "%llu %llu", &totalPages, &residentPages) == 2;
+    std::fclose(pFile);
+    return isRead ? static_cast<size_t>(residentPages * sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+// Names are written by the benchmarks themselves, so only quotes and backslashes can need escaping
+static std::string quoteJson(const std::string& text) {
+    std::string quoted = "\"";
+    for (char character : text) {
+        if (character == '"' || character == '\\') {
+            quoted += '\\';
+        }
+        quoted += character;
+    }
+    return quoted + "\"";
+}
+
+static bool writeJsonReport(const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+    std::fputs(std::format("{{\n  \"kernels\": {},\n  \"results\": [", quoteJson(GetSampleConversionKernels().name))
+                   .c_str(),
+               file);
+    for (size_t i = 0; i < g_recordedResults.size(); ++i) {
+        const RecordedResult& result = g_recordedResults[i];
+        std::string metrics;
+        for (const auto& [metricName, value] : result.metrics) {
+            // JSON has no infinities or NaNs, a skipped or degenerate measurement is written as null
+            metrics += std::format("{}{}: {}", metrics.empty() ? "" : ", ", quoteJson(metricName),
+                                   std::isfinite(value) ? std::format("{}", value) : "null");
+        }
+        std::fputs(std::format("{}\n    {{\"name\": {}, \"metrics\": {{{}}}}}", i == 0 ? "" : ",",
+                               quoteJson(result.name), metrics)
+                       .c_str(),
+                   file);
+    }
+    std::fputs("\n  ]\n}\n", file);
+    return std::fclose(file) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::fputs("Usage: sim_bench [--json <file>]\n", stderr);
+            return 2;
+        }
+    }
+
+    RunSampleConversionBenchmarks();
+    RunResamplerBenchmarks();
+    RunDeviceBenchmarks();
+    RunRenderBenchmarks();
+    RunAudioBenchmarks();
+    RunHistoryBenchmarks();
+    RunLoggingBenchmarks();
+    if (jsonPath != nullptr && !writeJsonReport(jsonPath)) {
+        return 1;
+    }
+    return g_failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Runs the function the given number of times and returns the fastest run, which is the least disturbed by the OS.
+// The setup runs before every repetition and is not measured
+template <typename Setup, typename Function>
+double MeasureBestMilliseconds(Setup&& setup, Function&& function, int repetitions) {
+    double bestMilliseconds = 0.0;
+    for (int i = 0; i < repetitions; ++i) {
+        setup();
+        auto startTime = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+        if (i == 0 || duration.count() < bestMilliseconds) {
+            bestMilliseconds = duration.count();
+        }
+    }
+    return bestMilliseconds;
+}
+
+// Same for functions which need no setup
+template <typename Function>
+double MeasureBestMilliseconds(Function&& function, int repetitions) {
+    return MeasureBestMilliseconds([] {}, std::forward<Function>(function), repetitions);
+}
+
+// Keeps the compiler from optimizing away work whose result is otherwise unused
+void ConsumeBenchmarkResult(const void* pData, size_t size);
+
+// Named values of one benchmark case, e.g. {"ms", 1.5}. Names are stable, so reports of two builds can be compared
+using BenchmarkMetrics = std::vector<std::pair<std::string, double>>;
+// Adds the case to the machine-readable report, the printed tables are not affected
+void RecordBenchmarkResult(const std::string& name, const BenchmarkMetrics& metrics);
+// For cases which also check what they measure, sim_bench then exits with an error after the remaining cases
+void ReportBenchmarkFailure(const std::string& message);
+// Resident memory of the whole process, 0 where it cannot be read
+size_t GetResidentMemoryBytes();
+
+void RunSampleConversionBenchmarks();
+void RunDeviceBenchmarks();
+void RunResamplerBenchmarks();
+void RunRenderBenchmarks();
+void RunAudioBenchmarks();
+void RunHistoryBenchmarks();
+void RunLoggingBenchmarks();
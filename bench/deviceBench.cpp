@@ -0,0 +1,73 @@
+#include "audio.h"
+#include "benchmarks.h"
+#include "deviceRegistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <vector>
+
+static constexpr int DEVICE_LOOKUP_REPETITIONS = 5;
+static constexpr size_t DEVICE_LOOKUPS = 1000;
+
+static void printDeviceLookupResult(const std::string& name, double milliseconds) {
+    const double microsecondsPerLookup = milliseconds * 1000.0 / DEVICE_LOOKUPS;
+    const double lookupsPerSecond = DEVICE_LOOKUPS / milliseconds * 1000.0;
+    std::puts(std::format("{:<28}{:>16.3f}{:>14.0f}", name, microsecondsPerLookup, lookupsPerSecond).c_str());
+    RecordBenchmarkResult(name, {{"us_per_lookup", microsecondsPerLookup}, {"lookups_per_s", lookupsPerSecond}});
+}
+
+// Checking the selected device before every utterance, by enumerating the devices as each utterance used to and
+// with the registry which keeps the list between device changes
+void RunDeviceBenchmarks() {
+    CDeviceRegistry registry;
+    const auto selectedDeviceID = registry.getDeviceId(0);
+    if (!selectedDeviceID.has_value()) {
+        std::puts("No playback device, skipping the device lookup benchmarks");
+        return;
+    }
+    std::puts(std::format("Selected device lookup, {} utterances per run, best of {} runs", DEVICE_LOOKUPS,
+                          DEVICE_LOOKUP_REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<28}{:>16}{:>14}", "path", "us per lookup", "lookups/s").c_str());
+
+    const double enumerationMilliseconds = MeasureBestMilliseconds(
+        [&] {
+            size_t foundCount = 0;
+            for (size_t i = 0; i < DEVICE_LOOKUPS; ++i) {
+                ma_device_info* pDeviceInfos;
+                ma_uint32 deviceCount;
+                if (ma_context_get_devices(g_AudioContext, &pDeviceInfos, &deviceCount, nullptr, nullptr) !=
+                    MA_SUCCESS) {
+                    continue;
+                }
+                std::vector<DeviceInfo> devices;
+                devices.reserve(deviceCount);
+                for (ma_uint32 j = 0; j < deviceCount; ++j) {
+                    devices.push_back(
+                        DeviceInfo(pDeviceInfos[j].id, pDeviceInfos[j].name, pDeviceInfos[j].isDefault == MA_TRUE));
+                }
+                std::stable_sort(devices.begin(), devices.end(), [](const DeviceInfo& first, const DeviceInfo& second) {
+                    return first.isDefault > second.isDefault;
+                });
+                foundCount += std::any_of(devices.begin(), devices.end(), [&](const DeviceInfo& device) {
+                    return ma_device_id_equal(&device.id, &*selectedDeviceID) == MA_TRUE;
+                });
+            }
+            ConsumeBenchmarkResult(&foundCount, sizeof(foundCount));
+        },
+        DEVICE_LOOKUP_REPETITIONS);
+    printDeviceLookupResult("device_lookup/enumerate", enumerationMilliseconds);
+
+    const double registryMilliseconds = MeasureBestMilliseconds(
+        [&] {
+            size_t foundCount = 0;
+            for (size_t i = 0; i < DEVICE_LOOKUPS; ++i) {
+                foundCount += registry.contains(*selectedDeviceID);
+            }
+            ConsumeBenchmarkResult(&foundCount, sizeof(foundCount));
+        },
+        DEVICE_LOOKUP_REPETITIONS);
+    printDeviceLookupResult("device_lookup/registry", registryMilliseconds);
+}
@@ -0,0 +1,215 @@
+#include "benchmarks.h"
+#include "historyLog.h"
+#include "historyStorage.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static constexpr size_t HISTORY_SIZES[] = {1000, 10000, 100000, 1000000};
+static constexpr size_t LOOKUP_COUNT = 1000;
+// Filling a size is skipped when it is estimated to take longer, pushes take constant time so it grows linearly
+static constexpr double FILL_BUDGET_MILLISECONDS = 10000.0;
+// Capacity of the storage filled with every line, so all but the newest lines are evicted on the way
+static constexpr size_t CAPPED_HISTORY_CAPACITY = 1000;
+static constexpr size_t HISTORY_LOG_SIZES[] = {100000, 1000000};
+static constexpr int HISTORY_LOG_LOAD_REPETITIONS = 3;
+static constexpr size_t HISTORY_SEARCH_SIZES[] = {1000, 10000, 100000};
+static constexpr int HISTORY_SEARCH_REPETITIONS = 1000;
+static constexpr const char* HISTORY_SEARCH_WORDS[] = {"hello", "world", "good",    "morning", "speak", "voice",
+                                                       "chat",  "team",  "discord", "yes",     "no",    "thanks"};
+// Name in the report and the query: short and long prefixes, a misspelled phrase and a query nothing matches
+static constexpr std::pair<const char*, const char*> HISTORY_SEARCH_QUERIES[] = {
+    {"prefix_1", "g"}, {"prefix_9", "good morn"}, {"fuzzy", "moring speek"}, {"miss", "xyzzy"}};
+
+static std::string makeHistoryLine(size_t index) {
+    return std::format("History line number {:07}", index);
+}
+
+// Startup cost of a saved history: mapping the log, indexing it and filling the storage
+static void runHistoryLogBenchmarks() {
+    const std::filesystem::path logPath = std::filesystem::temp_directory_path() / "sim_bench_history.log";
+    std::puts("History log load");
+    std::puts(std::format("{:<12}{:>12}{:>12}{:>14}", "entries", "records", "load ms", "file MB").c_str());
+    for (size_t size : HISTORY_LOG_SIZES) {
+        std::error_code error;
+        std::filesystem::remove(logPath, error);
+        {
+            HistoryLog log;
+            if (!log.open(logPath, [](std::string_view) { return true; })) {
+                std::puts("Failed to create the history log");
+                return;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                log.append(makeHistoryLine(i));
+            }
+            // Every other line is spoken again, so the loader has superseded records to skip
+            for (size_t i = 0; i < size; i += 2) {
+                log.append(makeHistoryLine(i));
+            }
+        }
+        const size_t recordCount = size + (size + 1) / 2;
+        const double fileMegabytes = std::filesystem::file_size(logPath, error) / (1024.0 * 1024.0);
+
+        std::unique_ptr<HistoryStorage> storage;
+        size_t loadedCount = 0;
+        const double loadMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                // Only the newest storage is kept, the destructor of the old one is not measured
+                storage.reset();
+                storage = std::make_unique<HistoryStorage>(0);
+            },
+            [&] {
+                storage->openLog(logPath);
+                loadedCount = storage->size();
+            },
+            HISTORY_LOG_LOAD_REPETITIONS);
+        storage.reset();
+        std::filesystem::remove(logPath, error);
+        ConsumeBenchmarkResult(&loadedCount, sizeof(loadedCount));
+
+        std::puts(std::format("{:<12}{:>12}{:>12.1f}{:>14.1f}", loadedCount, recordCount, loadMilliseconds,
+                              fileMegabytes)
+                      .c_str());
+        RecordBenchmarkResult(std::format("history_log/{}", size),
+                              {{"load_ms", loadMilliseconds}, {"file_mb", fileMegabytes}});
+    }
+}
+
+// Time to get the ranked matches of what the user typed so far, as the window does on every key press
+static void runHistorySearchBenchmarks() {
+    std::puts(std::format("History search, best of {} queries per size, {} results each", HISTORY_SEARCH_REPETITIONS,
+                          HISTORY_SEARCH_DEFAULT_RESULT_COUNT)
+                  .c_str());
+    std::string header = std::format("{:<12}", "entries");
+    for (const auto& [name, query] : HISTORY_SEARCH_QUERIES) {
+        header += std::format("{:>14}", std::format("{} us", name));
+    }
+    std::puts(header.c_str());
+    for (size_t size : HISTORY_SEARCH_SIZES) {
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> wordDistribution(0, std::size(HISTORY_SEARCH_WORDS) - 1);
+        std::uniform_int_distribution<size_t> lengthDistribution(2, 7);
+        HistoryStorage storage(0);
+        for (size_t i = 0; i < size; ++i) {
+            std::string line;
+            for (size_t word = lengthDistribution(random); word > 0; --word) {
+                line += HISTORY_SEARCH_WORDS[wordDistribution(random)];
+                line += ' ';
+            }
+            // Numbered, so every line is a new phrase
+            storage.push(line + std::to_string(i));
+        }
+
+        std::string row = std::format("{:<12}", size);
+        BenchmarkMetrics metrics;
+        size_t resultCount = 0;
+        for (const auto& [name, query] : HISTORY_SEARCH_QUERIES) {
+            const std::string queryText = query;
+            const double milliseconds = MeasureBestMilliseconds(
+                [&] { resultCount += storage.search(queryText).size(); }, HISTORY_SEARCH_REPETITIONS);
+            row += std::format("{:>14.2f}", milliseconds * 1000.0);
+            metrics.emplace_back(std::format("{}_us", name), milliseconds * 1000.0);
+        }
+        ConsumeBenchmarkResult(&resultCount, sizeof(resultCount));
+        std::puts(row.c_str());
+        RecordBenchmarkResult(std::format("history_search/{}", size), metrics);
+    }
+}
+
+void RunHistoryBenchmarks() {
+    std::puts(std::format("HistoryStorage, {} lookups per size", LOOKUP_COUNT).c_str());
+    std::puts(std::format("{:<12}{:>12}{:>12}{:>14}{:>12}{:>14}{:>16}", "entries", "fill ms", "push us",
+                          "re-push us", "next us", "previous us", "capped push us")
+                  .c_str());
+    double previousFillMilliseconds = 0.0;
+    size_t previousSize = 0;
+    for (size_t size : HISTORY_SIZES) {
+        if (previousSize != 0) {
+            const double ratio = (double)size / previousSize;
+            if (previousFillMilliseconds * ratio > FILL_BUDGET_MILLISECONDS) {
+                std::puts(std::format("{:<12}skipped, filling would take too long", size).c_str());
+                continue;
+            }
+        }
+        std::vector<std::string> lines(size);
+        for (size_t i = 0; i < size; ++i) {
+            lines[i] = makeHistoryLine(i);
+        }
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> distribution(0, size - 1);
+        std::vector<const std::string*> lookups(LOOKUP_COUNT);
+        for (auto& pLine : lookups) {
+            pLine = &lines[distribution(random)];
+        }
+
+        HistoryStorage storage(0);
+        const double fillMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (const auto& line : lines) {
+                    storage.push(line);
+                }
+            },
+            1);
+        size_t resultSize = 0;
+        const double nextMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (const std::string* pLine : lookups) {
+                    resultSize += storage.getNextByText(*pLine).size();
+                }
+            },
+            1);
+        const double previousMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (const std::string* pLine : lookups) {
+                    resultSize += storage.getPreviousByText(*pLine).size();
+                }
+            },
+            1);
+        // Pushing a line again moves it to the end, which is what repeating an old phrase does
+        const double repushMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (const std::string* pLine : lookups) {
+                    storage.push(*pLine);
+                }
+            },
+            1);
+        HistoryStorage cappedStorage(CAPPED_HISTORY_CAPACITY);
+        const double cappedFillMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                for (const auto& line : lines) {
+                    cappedStorage.push(line);
+                }
+            },
+            1);
+        resultSize += cappedStorage.size();
+        ConsumeBenchmarkResult(&resultSize, sizeof(resultSize));
+
+        const double pushMicroseconds = fillMilliseconds * 1000.0 / size;
+        const double repushMicroseconds = repushMilliseconds * 1000.0 / LOOKUP_COUNT;
+        const double nextMicroseconds = nextMilliseconds * 1000.0 / LOOKUP_COUNT;
+        const double previousMicroseconds = previousMilliseconds * 1000.0 / LOOKUP_COUNT;
+        const double cappedPushMicroseconds = cappedFillMilliseconds * 1000.0 / size;
+        std::puts(std::format("{:<12}{:>12.1f}{:>12.3f}{:>14.3f}{:>12.3f}{:>14.3f}{:>16.3f}", size, fillMilliseconds,
+                              pushMicroseconds, repushMicroseconds, nextMicroseconds, previousMicroseconds,
+                              cappedPushMicroseconds)
+                      .c_str());
+        RecordBenchmarkResult(std::format("history/{}", size), {{"fill_ms", fillMilliseconds},
+                                                                {"push_us", pushMicroseconds},
+                                                                {"repush_us", repushMicroseconds},
+                                                                {"next_us", nextMicroseconds},
+                                                                {"previous_us", previousMicroseconds},
+                                                                {"capped_push_us", cappedPushMicroseconds}});
+        previousFillMilliseconds = fillMilliseconds;
+        previousSize = size;
+    }
+    runHistoryLogBenchmarks();
+    runHistorySearchBenchmarks();
+}
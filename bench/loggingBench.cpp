@@ -0,0 +1,92 @@
+#include "benchmarks.h"
+#include "rtLogger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <memory>
+#include <spdlog/async.h>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <system_error>
+#include <thread>
+
+// Calls per run, half a real-time ring, so no message is dropped and only the calling thread is measured
+static constexpr size_t LOG_CALLS = RT_LOG_MESSAGES_PER_THREAD / 2;
+static constexpr int LOG_REPETITIONS = 20;
+// Same queue as InitializeLogging
+static constexpr size_t LOG_QUEUE_SIZE = 8192;
+
+// The sinks and the drain thread catch up between runs, so every run starts with empty queues
+static void waitForLogDrain() {
+    std::this_thread::sleep_for(RT_LOG_DRAIN_INTERVAL * 2);
+}
+
+static void printLoggingResult(const std::string& name, double milliseconds) {
+    const double callsPerSecond = LOG_CALLS / milliseconds * 1000.0;
+    const double nanosecondsPerCall = milliseconds * 1000000.0 / LOG_CALLS;
+    std::puts(std::format("{:<24}{:>14.0f}{:>14.0f}", name, nanosecondsPerCall, callsPerSecond).c_str());
+    RecordBenchmarkResult(name, {{"ns_per_call", nanosecondsPerCall}, {"calls_per_s", callsPerSecond}});
+}
+
+// Real-time logging from the calling thread, formatted by the drain thread or written to the binary log
+static void runRtLoggingBenchmark(const std::string& name, const std::filesystem::path& binaryLogPath) {
+    if constexpr (SPDLOG_LEVEL_DEBUG < SIM_RT_LOG_LEVEL) {
+        std::puts(std::format("{:<24}compiled out by SIM_RT_LOG_LEVEL", name).c_str());
+        RecordBenchmarkResult(name, {{"ns_per_call", std::numeric_limits<double>::quiet_NaN()},
+                                     {"calls_per_s", std::numeric_limits<double>::quiet_NaN()}});
+        return;
+    }
+    if (!binaryLogPath.empty() && !g_RtLogger.openBinaryLog(binaryLogPath)) {
+        std::puts(std::format("{:<24}failed to open the binary log", name).c_str());
+        return;
+    }
+    g_RtLogger.start(spdlog::level::debug);
+    const double milliseconds = MeasureBestMilliseconds(
+        waitForLogDrain,
+        [] {
+            for (size_t i = 0; i < LOG_CALLS; ++i) {
+                SIM_RT_DEBUG("Logged message {} after {} ms on the {} device", i, 1.5, RtLogLiteral("primary"));
+            }
+        },
+        LOG_REPETITIONS);
+    g_RtLogger.stop();
+    printLoggingResult(name, milliseconds);
+}
+
+void RunLoggingBenchmarks() {
+    std::puts(std::format("Debug logging, {} calls with the same arguments per run, best of {} runs", LOG_CALLS,
+                          LOG_REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<24}{:>14}{:>14}", "path", "ns per call", "calls/s").c_str());
+
+    // Set up as in sim, the sinks write nothing as only the cost to the calling thread is measured
+    auto pPreviousLogger = spdlog::default_logger();
+    spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+    auto pLogger = std::make_shared<spdlog::async_logger>("sim_bench", std::make_shared<spdlog::sinks::null_sink_mt>(),
+                                                          spdlog::thread_pool(),
+                                                          spdlog::async_overflow_policy::overrun_oldest);
+    pLogger->set_level(spdlog::level::debug);
+    spdlog::set_default_logger(pLogger);
+
+    const double spdlogMilliseconds = MeasureBestMilliseconds(
+        waitForLogDrain,
+        [] {
+            for (size_t i = 0; i < LOG_CALLS; ++i) {
+                spdlog::debug("Logged message {} after {} ms on the {} device", i, 1.5, "primary");
+            }
+        },
+        LOG_REPETITIONS);
+    // --binary-log only changes where the real-time messages go, spdlog logs the same either way
+    printLoggingResult("logging/spdlog", spdlogMilliseconds);
+    runRtLoggingBenchmark("logging/rt_text", {});
+    const std::filesystem::path binaryLogPath = std::filesystem::temp_directory_path() / "sim_bench.blog";
+    runRtLoggingBenchmark("logging/rt_binary", binaryLogPath);
+    std::error_code error;
+    std::filesystem::remove(binaryLogPath, error);
+
+    spdlog::set_default_logger(pPreviousLogger);
+}
@@ -0,0 +1,82 @@
+#include "audio.h"
+#include "benchmarks.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+static constexpr int RENDER_REPETITIONS = 5;
+// Long enough for the buffer to stand out from the rest of the resident memory
+static constexpr size_t IN_PLACE_RENDER_SECONDS = 120;
+
+// A voice which already renders at the playback rate, its buffer is played in place. The copy path is what
+// renderAudioData did before: copy the SRAL buffer into a vector of its own, then free it
+void RunRenderBenchmarks() {
+    const ma_uint32 sampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
+    const size_t bufferSize = sampleRate * IN_PLACE_RENDER_SECONDS * sizeof(int16_t);
+    std::vector<ma_uint8> phrase(bufferSize);
+    std::mt19937 random(42);
+    for (auto& byte : phrase) {
+        byte = (ma_uint8)random();
+    }
+    auto makeSralBuffer = [&] {
+        void* pBuffer = malloc(bufferSize);
+        std::memcpy(pBuffer, phrase.data(), bufferSize);
+        return pBuffer;
+    };
+    size_t residentBefore = 0;
+    auto getResidentGrowth = [&] {
+        const size_t resident = GetResidentMemoryBytes();
+        return resident > residentBefore ? resident - residentBefore : 0;
+    };
+    auto toMegabytes = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+    std::puts(std::format("Rendering {} s of mono s16 at the playback rate of {} Hz, best of {} runs",
+                          IN_PLACE_RENDER_SECONDS, sampleRate, RENDER_REPETITIONS)
+                  .c_str());
+    std::puts(std::format("{:<28}{:>12}{:>16}", "path", "ms", "peak RSS MB").c_str());
+
+    // Peak memory is taken once, while both the SRAL buffer and the rendered speech are alive
+    residentBefore = GetResidentMemoryBytes();
+    void* pBuffer = makeSralBuffer();
+    auto speech = g_Audio.renderAudioData(1, (int)sampleRate, 16, bufferSize, pBuffer);
+    const size_t inPlacePeak = getResidentGrowth();
+    if (speech == nullptr || speech->pData != pBuffer) {
+        ReportBenchmarkFailure("renderAudioData copied a buffer which was already at the playback rate");
+    }
+    speech.reset();
+    const double inPlaceMilliseconds = MeasureBestMilliseconds(
+        [&] { pBuffer = makeSralBuffer(); },
+        [&] {
+            auto renderedSpeech = g_Audio.renderAudioData(1, (int)sampleRate, 16, bufferSize, pBuffer);
+            ConsumeBenchmarkResult(renderedSpeech->pData, renderedSpeech->sizeInBytes());
+        },
+        RENDER_REPETITIONS);
+
+    auto copySralBuffer = [&](size_t* pPeak) {
+        auto pcmData = std::make_shared<std::vector<ma_uint8>>(bufferSize);
+        std::memcpy(pcmData->data(), pBuffer, bufferSize);
+        if (pPeak != nullptr) {
+            *pPeak = getResidentGrowth();
+        }
+        free(pBuffer);
+        ConsumeBenchmarkResult(pcmData->data(), pcmData->size());
+    };
+    residentBefore = GetResidentMemoryBytes();
+    pBuffer = makeSralBuffer();
+    size_t copyPeak = 0;
+    copySralBuffer(&copyPeak);
+    const double copyMilliseconds = MeasureBestMilliseconds([&] { pBuffer = makeSralBuffer(); },
+                                                            [&] { copySralBuffer(nullptr); }, RENDER_REPETITIONS);
+
+    for (const auto& [name, milliseconds, peak] : {std::tuple("render/in_place", inPlaceMilliseconds, inPlacePeak),
+                                                   std::tuple("render/copy", copyMilliseconds, copyPeak)}) {
+        std::puts(std::format("{:<28}{:>12.3f}{:>16.1f}", name, milliseconds, toMegabytes(peak)).c_str());
+        RecordBenchmarkResult(name, {{"ms", milliseconds}, {"peak_rss_mb", toMegabytes(peak)}});
+    }
+}
@@ -0,0 +1,127 @@
+#include "benchmarks.h"
+#include "polyphaseResampler.h"
+
+#include <cmath>
+#include <cstdio>
+#include <format>
+#include <numbers>
+#include <vector>
+
+// The most common SAPI voice rate brought to the playback rate
+static constexpr ma_uint32 SAMPLE_RATE_IN = 22050;
+static constexpr ma_uint32 SAMPLE_RATE_OUT = 48000;
+static constexpr size_t THROUGHPUT_FRAMES = SAMPLE_RATE_IN * 60;
+static constexpr size_t TONE_FRAMES = SAMPLE_RATE_IN * 2;
+static constexpr int REPETITIONS = 5;
+// Edges are skipped, the filters ramp in and out of the silence around the clip there
+static constexpr size_t TONE_EDGE_FRAMES = 4096;
+
+static std::vector<float> resampleLinear(const std::vector<float>& input) {
+    ma_resampler_config config =
+        ma_resampler_config_init(ma_format_f32, 1, SAMPLE_RATE_IN, SAMPLE_RATE_OUT, ma_resample_algorithm_linear);
+    ma_resampler resampler;
+    ma_resampler_init(&config, nullptr, &resampler);
+    ma_uint64 frameCountIn = input.size();
+    ma_uint64 frameCountOut = 0;
+    ma_resampler_get_expected_output_frame_count(&resampler, frameCountIn, &frameCountOut);
+    std::vector<float> output(frameCountOut);
+    ma_resampler_process_pcm_frames(&resampler, input.data(), &frameCountIn, output.data(), &frameCountOut);
+    output.resize(frameCountOut);
+    ma_resampler_uninit(&resampler, nullptr);
+    return output;
+}
+
+static std::vector<float> resamplePolyphase(PolyphaseResampler& resampler, const std::vector<float>& input) {
+    std::vector<float> output(resampler.getOutputFrameCount(input.size()));
+    resampler.process(input.data(), 1, input.size(), output.data());
+    return output;
+}
+
+static std::vector<float> makeTone(double frequency, size_t frameCount) {
+    std::vector<float> tone(frameCount);
+    for (size_t i = 0; i < frameCount; ++i) {
+        tone[i] = (float)(0.5 * std::sin(2.0 * std::numbers::pi * frequency * i / SAMPLE_RATE_IN));
+    }
+    return tone;
+}
+
+// THD+N in dB: everything except the fitted tone, relative to the tone. The fit ignores phase and delay
+static double measureThdPlusNoise(const std::vector<float>& output, double frequency) {
+    const size_t begin = TONE_EDGE_FRAMES;
+    const size_t end = output.size() - TONE_EDGE_FRAMES;
+    const double step = 2.0 * std::numbers::pi * frequency / SAMPLE_RATE_OUT;
+    // Least squares fit of a sine and a cosine at the tone frequency
+    double sinSinSum = 0.0;
+    double cosCosSum = 0.0;
+    double sinCosSum = 0.0;
+    double sinSum = 0.0;
+    double cosSum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        const double sinValue = std::sin(step * i);
+        const double cosValue = std::cos(step * i);
+        sinSinSum += sinValue * sinValue;
+        cosCosSum += cosValue * cosValue;
+        sinCosSum += sinValue * cosValue;
+        sinSum += output[i] * sinValue;
+        cosSum += output[i] * cosValue;
+    }
+    const double determinant = sinSinSum * cosCosSum - sinCosSum * sinCosSum;
+    const double sinAmplitude = (sinSum * cosCosSum - cosSum * sinCosSum) / determinant;
+    const double cosAmplitude = (cosSum * sinSinSum - sinSum * sinCosSum) / determinant;
+
+    double tonePower = 0.0;
+    double residualPower = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        const double fitted = sinAmplitude * std::sin(step * i) + cosAmplitude * std::cos(step * i);
+        tonePower += fitted * fitted;
+        residualPower += (output[i] - fitted) * (output[i] - fitted);
+    }
+    return 10.0 * std::log10(residualPower / tonePower);
+}
+
+void RunResamplerBenchmarks() {
+    auto polyphaseResampler = PolyphaseResampler::create(SAMPLE_RATE_IN, SAMPLE_RATE_OUT);
+    if (polyphaseResampler == nullptr) {
+        std::puts("Polyphase resampler does not support the benchmark rates");
+        return;
+    }
+
+    std::puts(std::format("Resampling mono f32 from {} Hz to {} Hz, single thread", SAMPLE_RATE_IN, SAMPLE_RATE_OUT)
+                  .c_str());
+    const std::vector<float> signal = makeTone(440.0, THROUGHPUT_FRAMES);
+    const double linearMilliseconds = MeasureBestMilliseconds(
+        [&] {
+            auto output = resampleLinear(signal);
+            ConsumeBenchmarkResult(output.data(), output.size() * sizeof(float));
+        },
+        REPETITIONS);
+    const double polyphaseMilliseconds = MeasureBestMilliseconds(
+        [&] {
+            auto output = resamplePolyphase(*polyphaseResampler, signal);
+            ConsumeBenchmarkResult(output.data(), output.size() * sizeof(float));
+        },
+        REPETITIONS);
+    const double outputFrames = (double)polyphaseResampler->getOutputFrameCount(THROUGHPUT_FRAMES);
+    std::puts(std::format("{:<12}{:>14}{:>20}", "resampler", "ms per minute", "Mframes/s per core").c_str());
+    std::puts(std::format("{:<12}{:>14.2f}{:>20.1f}", "linear", linearMilliseconds,
+                          outputFrames / linearMilliseconds / 1000.0)
+                  .c_str());
+    std::puts(std::format("{:<12}{:>14.2f}{:>20.1f}", "sinc", polyphaseMilliseconds,
+                          outputFrames / polyphaseMilliseconds / 1000.0)
+                  .c_str());
+    RecordBenchmarkResult("resampler/linear", {{"ms_per_minute", linearMilliseconds},
+                                               {"mframes_per_s", outputFrames / linearMilliseconds / 1000.0}});
+    RecordBenchmarkResult("resampler/sinc", {{"ms_per_minute", polyphaseMilliseconds},
+                                             {"mframes_per_s", outputFrames / polyphaseMilliseconds / 1000.0}});
+
+    std::puts("THD+N of a half scale tone, lower is better");
+    std::puts(std::format("{:<12}{:>14}{:>14}", "tone Hz", "linear dB", "sinc dB").c_str());
+    for (double frequency : {440.0, 1000.0, 4000.0, 8000.0, 10000.0}) {
+        const std::vector<float> tone = makeTone(frequency, TONE_FRAMES);
+        const double linearDb = measureThdPlusNoise(resampleLinear(tone), frequency);
+        const double sincDb = measureThdPlusNoise(resamplePolyphase(*polyphaseResampler, tone), frequency);
+        std::puts(std::format("{:<12.0f}{:>14.1f}{:>14.1f}", frequency, linearDb, sincDb).c_str());
+        RecordBenchmarkResult(std::format("resampler_thd_n/{:.0f}", frequency),
+                              {{"linear_db", linearDb}, {"sinc_db", sincDb}});
+    }
+}
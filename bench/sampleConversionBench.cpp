@@ -0,0 +1,101 @@
+#include "benchmarks.h"
+#include "sampleConversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <random>
+#include <vector>
+
+// Ten seconds of stereo speech at the playback rate
+static constexpr size_t SAMPLE_COUNT = 48000 * 2 * 10;
+static constexpr int REPETITIONS = 20;
+static constexpr float GAIN = 0.8f;
+
+struct FormatCase {
+    const char* name;
+    ma_format format;
+};
+
+static std::vector<ma_uint8> makeInput(ma_format format) {
+    std::vector<ma_uint8> input(SAMPLE_COUNT * ma_get_bytes_per_sample(format));
+    std::mt19937 random(42);
+    if (format == ma_format_f32) {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        auto* pSamples = (float*)input.data();
+        std::generate(pSamples, pSamples + SAMPLE_COUNT, [&] { return distribution(random); });
+    } else {
+        std::generate(input.begin(), input.end(), [&] { return (ma_uint8)random(); });
+    }
+    return input;
+}
+
+void RunSampleConversionBenchmarks() {
+    static const FormatCase formats[] = {{"u8", ma_format_u8},
+                                         {"s16", ma_format_s16},
+                                         {"s24", ma_format_s24},
+                                         {"s32", ma_format_s32},
+                                         {"f32", ma_format_f32}};
+    std::vector<const SampleConversionKernels*> kernelSets = {&GetScalarSampleConversionKernels()};
+    if (const auto* pKernels = GetSse2SampleConversionKernels()) {
+        kernelSets.push_back(pKernels);
+    }
+    if (const auto* pKernels = GetAvx2SampleConversionKernels()) {
+        kernelSets.push_back(pKernels);
+    }
+
+    std::puts(std::format("Sample conversion to f32 with gain, {} samples, best of {} runs", SAMPLE_COUNT, REPETITIONS)
+                  .c_str());
+    std::puts(std::format("Dispatched kernels: {}", GetSampleConversionKernels().name).c_str());
+    std::puts(std::format("{:<8}{:<12}{:>12}{:>14}{:>10}{:>12}", "format", "kernels", "ms", "Msamples/s", "speedup",
+                          "max error")
+                  .c_str());
+
+    std::vector<float> reference(SAMPLE_COUNT);
+    std::vector<float> output(SAMPLE_COUNT);
+    for (const FormatCase& formatCase : formats) {
+        const std::vector<ma_uint8> input = makeInput(formatCase.format);
+
+        // The path this replaces: miniaudio conversion followed by a separate volume pass in the device callback
+        const double baselineMilliseconds = MeasureBestMilliseconds(
+            [&] {
+                ma_pcm_convert(reference.data(), ma_format_f32, input.data(), formatCase.format, SAMPLE_COUNT,
+                               ma_dither_mode_none);
+                for (float& sample : reference) {
+                    sample *= GAIN;
+                }
+                ConsumeBenchmarkResult(reference.data(), reference.size() * sizeof(float));
+            },
+            REPETITIONS);
+        std::puts(std::format("{:<8}{:<12}{:>12.3f}{:>14.1f}{:>10}{:>12}", formatCase.name, "miniaudio",
+                              baselineMilliseconds, SAMPLE_COUNT / baselineMilliseconds / 1000.0, "1.00x", "-")
+                      .c_str());
+        RecordBenchmarkResult(std::format("sample_conversion/{}/miniaudio", formatCase.name),
+                              {{"ms", baselineMilliseconds},
+                               {"msamples_per_s", SAMPLE_COUNT / baselineMilliseconds / 1000.0}});
+
+        for (const SampleConversionKernels* pKernels : kernelSets) {
+            SampleConversionKernel kernel = pKernels->get(formatCase.format);
+            const double milliseconds = MeasureBestMilliseconds(
+                [&] {
+                    kernel(input.data(), output.data(), SAMPLE_COUNT, GAIN);
+                    ConsumeBenchmarkResult(output.data(), output.size() * sizeof(float));
+                },
+                REPETITIONS);
+            float maxError = 0.0f;
+            for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+                maxError = std::max(maxError, std::fabs(output[i] - reference[i]));
+            }
+            std::puts(std::format("{:<8}{:<12}{:>12.3f}{:>14.1f}{:>9.2f}x{:>12.2e}", formatCase.name, pKernels->name,
+                                  milliseconds, SAMPLE_COUNT / milliseconds / 1000.0,
+                                  baselineMilliseconds / milliseconds, maxError)
+                          .c_str());
+            RecordBenchmarkResult(std::format("sample_conversion/{}/{}", formatCase.name, pKernels->name),
+                                  {{"ms", milliseconds},
+                                   {"msamples_per_s", SAMPLE_COUNT / milliseconds / 1000.0},
+                                   {"max_error", maxError}});
+        }
+    }
+}
@@ -1,150 +1,607 @@
 #include "audio.h"
 
+#include "sampleConversion.h"
+
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 
 std::vector<DeviceInfo> Audio::getDevicesList() {
-    std::vector<DeviceInfo> deviceInfos;
-    ma_device_info* pDeviceInfos;
-    ma_uint32 deviceCount;
-    ma_result result = ma_context_get_devices(g_AudioContext, &pDeviceInfos, &deviceCount, nullptr, nullptr);
-    if (result != MA_SUCCESS) {
-        spdlog::critical("Failed to get list of devices");
-        throw std::exception("Failed to get list of devices");
-    }
-    deviceInfos.reserve(deviceCount);
-    for (ma_uint32 i = 0; i < deviceCount; ++i) {
-        deviceInfos.push_back(
-            DeviceInfo(pDeviceInfos[i].id, pDeviceInfos[i].name, pDeviceInfos[i].isDefault == MA_TRUE));
-    }
-    m_lastDevicesList = deviceInfos;
-    std::sort(m_lastDevicesList.begin(), m_lastDevicesList.end(),
-              [](const DeviceInfo& first, const DeviceInfo& second) { return first.isDefault > second.isDefault; });
-    return m_lastDevicesList;
+    return m_deviceRegistry.getDevices();
+}
+
+std::vector<DeviceInfo> Audio::refreshDevicesList() {
+    m_deviceRegistry.refresh();
+    return m_deviceRegistry.getDevices();
 }
 
 void Audio::selectDevice(size_t deviceIndex) {
-    if (m_lastDevicesList.empty()) {
+    auto deviceID = m_deviceRegistry.getDeviceId(deviceIndex);
+    if (!deviceID.has_value()) {
+        spdlog::warn("Device index {} is out of range. Falling back to 0.", deviceIndex);
+        deviceID = m_deviceRegistry.getDeviceId(0);
+    }
+    if (!deviceID.has_value()) {
         spdlog::warn("Cannot select audio device: device list is empty");
         return;
     }
-    if (deviceIndex >= m_lastDevicesList.size()) {
-        spdlog::warn("Device index {} is out of range. Falling back to 0.", deviceIndex);
-        deviceIndex = 0;
+    std::lock_guard lock(m_mutex);
+    m_selectedDeviceID = *deviceID;
+}
+
+void Audio::selectSecondaryDevices(const std::vector<size_t>& deviceIndices) {
+    std::vector<ma_device_id> deviceIDs;
+    for (size_t deviceIndex : deviceIndices) {
+        auto deviceID = m_deviceRegistry.getDeviceId(deviceIndex);
+        if (!deviceID.has_value()) {
+            spdlog::warn("Secondary device index {} is out of range, it is skipped", deviceIndex);
+            continue;
+        }
+        if (deviceIDs.size() + 1 == AUDIO_MAX_OUTPUT_DEVICES) {
+            spdlog::warn("At most {} devices can play at once, further secondary devices are skipped",
+                         AUDIO_MAX_OUTPUT_DEVICES);
+            break;
+        }
+        deviceIDs.push_back(*deviceID);
     }
-    m_selectedDeviceID = m_lastDevicesList[deviceIndex].id;
+    std::lock_guard lock(m_mutex);
+    m_secondaryDeviceIDs = std::move(deviceIDs);
 }
 
 bool Audio::playAudioData(const int channels, const int sampleRate, const int bitsPerSample, const uint64_t bufferSize,
                           const void* buffer) {
+    SIM_TRACE_ZONE("Audio::playAudioData");
+    auto speech = renderAudioData(channels, sampleRate, bitsPerSample, bufferSize, buffer);
+    if (speech == nullptr) {
+        return false;
+    }
+    return queueRenderedSpeech(std::move(speech));
+}
+
+RenderedSpeechPtr Audio::renderAudioData(const int channels, const int sampleRate, const int bitsPerSample,
+                                         const uint64_t bufferSize, const void* buffer) {
+    SIM_TRACE_ZONE("Audio::renderAudioData");
     if (buffer == nullptr) {
         spdlog::error("Speech buffer was nullptr");
-        return false;
+        return nullptr;
     }
 
     if (channels <= 0 || bitsPerSample <= 0 || sampleRate <= 0) {
         spdlog::error("Invalid audio metadata: channels={}, sampleRate={}, bitsPerSample={}", channels, sampleRate,
                       bitsPerSample);
         free((void*)buffer);
-        return false;
+        return nullptr;
     }
     ma_format format = determineFormat(bitsPerSample);
     if (format == ma_format_unknown) {
         spdlog::error("Unsupported bits per sample value: {}", bitsPerSample);
         free((void*)buffer);
-        return false;
+        return nullptr;
     }
+    const ma_uint32 playbackSampleRate = getPlaybackSampleRate();
+
+    auto speech = std::make_shared<RenderedSpeech>();
+    speech->format = format;
+    speech->channels = channels;
+    speech->sampleRate = playbackSampleRate;
+    speech->frameCount = 0;
+    speech->pData = nullptr;
     if (bufferSize == 0) {
         free((void*)buffer);
-        return true;
+        return speech;
     }
 
-    auto devices = getDevicesList();
-    if (devices.empty()) {
-        spdlog::error("No playback devices are available");
-        free((void*)buffer);
-        return false;
-    }
-    if (std::find_if(devices.begin(), devices.end(), [&](const DeviceInfo& device) {
-            return ma_device_id_equal(&device.id, &m_selectedDeviceID);
-        }) == devices.end()) {
-        spdlog::warn("Selected audio device is unavailable. Falling back to index 0.");
-        m_selectedDeviceID = devices[0].id;
+    const ma_uint64 frameCountIn = (bufferSize * 8) / (channels * bitsPerSample);
+    if ((ma_uint32)sampleRate == playbackSampleRate) {
+        // Already at the playback rate, so the speech adopts the SRAL buffer and is played from it in place
+        speech->frameCount = frameCountIn;
+        speech->pData = (const ma_uint8*)buffer;
+        speech->storage = std::shared_ptr<const void>(buffer, [](const void* pBuffer) { free((void*)pBuffer); });
+        return speech;
     }
 
-    freeSounds();
-    updateDevice();
-    updateResampler(format, channels, sampleRate, AUDIO_DEFAULT_SAMPLE_RATE);
-    const ma_uint64 frameCountIn = (bufferSize * 8) / (channels * bitsPerSample);
+    std::lock_guard lock(m_mutex);
+    if (m_resamplerType == AudioResampler::Sinc) {
+        if (auto resampledSpeech =
+                renderWithPolyphaseResampler(format, channels, sampleRate, playbackSampleRate, frameCountIn, buffer)) {
+            free((void*)buffer);
+            return resampledSpeech;
+        }
+        spdlog::warn("No polyphase filter for {} Hz, resampling linearly", sampleRate);
+    }
+    updateResampler(format, channels, sampleRate, playbackSampleRate);
     ma_uint64 frameCountOut = 0;
     ma_result result =
         ma_resampler_get_expected_output_frame_count(&*m_resampler->resampler, frameCountIn, &frameCountOut);
     if (result != MA_SUCCESS) {
         spdlog::error("Failed to get expected frame count for resampling: {}", ma_result_description(result));
         free((void*)buffer);
-        return false;
+        return nullptr;
     }
 
-    auto* pPayload = new SoundPayload();
-    pPayload->pcmData.resize(frameCountOut * channels * (bitsPerSample / 8));
-
-    if (sampleRate != AUDIO_DEFAULT_SAMPLE_RATE) {
-        result = m_resampler->processAudioData(buffer, frameCountIn, pPayload->pcmData.data(), frameCountOut);
-        if (result != MA_SUCCESS) {
-            spdlog::error("Failed to resample audio: {}", ma_result_description(result));
-            free((void*)buffer);
-            delete pPayload;
-            return false;
-        }
-        pPayload->pcmData.resize(frameCountOut * channels * (bitsPerSample / 8));
-    } else {
-        frameCountOut = frameCountIn;
-        pPayload->pcmData.assign((uint8_t*)buffer, (uint8_t*)buffer + bufferSize);
+    auto pcmData = std::make_shared<std::vector<ma_uint8>>(frameCountOut * channels * (bitsPerSample / 8));
+    result = m_resampler->processAudioData(buffer, frameCountIn, pcmData->data(), frameCountOut);
+    if (result != MA_SUCCESS) {
+        spdlog::error("Failed to resample audio: {}", ma_result_description(result));
+        free((void*)buffer);
+        return nullptr;
     }
+    pcmData->resize(frameCountOut * channels * (bitsPerSample / 8));
+    speech->frameCount = frameCountOut;
+    speech->pData = pcmData->data();
+    speech->storage = std::move(pcmData);
 
     free((void*)buffer);
+    return speech;
+}
 
-    if (frameCountOut == 0) {
-        delete pPayload;
-        return true;
+RenderedSpeechPtr Audio::renderWithPolyphaseResampler(ma_format format, ma_uint32 channels, ma_uint32 sampleRate,
+                                                      ma_uint32 sampleRateOut, ma_uint64 frameCountIn,
+                                                      const void* buffer) {
+    if (m_polyphaseResampler == nullptr || m_polyphaseResampler->getSampleRateIn() != sampleRate ||
+        m_polyphaseResampler->getSampleRateOut() != sampleRateOut) {
+        m_polyphaseResampler = PolyphaseResampler::create(sampleRate, sampleRateOut);
+        if (m_polyphaseResampler == nullptr) {
+            return nullptr;
+        }
     }
 
-    ma_audio_buffer_config config =
-        ma_audio_buffer_config_init(format, channels, frameCountOut, pPayload->pcmData.data(), nullptr);
-    config.sampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
+    // The filter works in f32 and its output stays in f32, so no precision is lost to requantization
+    m_polyphaseInput.resize(frameCountIn * channels);
+    ConvertSamplesToF32(buffer, format, m_polyphaseInput.data(), m_polyphaseInput.size(), 1.0f);
+    const ma_uint64 frameCountOut = m_polyphaseResampler->getOutputFrameCount(frameCountIn);
+    auto pcmData = std::make_shared<std::vector<ma_uint8>>(frameCountOut * channels * sizeof(float));
+    m_polyphaseResampler->process(m_polyphaseInput.data(), channels, frameCountIn, (float*)pcmData->data());
 
-    pPayload->audioBuffer = std::make_unique<ma_audio_buffer>();
-    result = ma_audio_buffer_init(&config, &*pPayload->audioBuffer);
-    if (result != MA_SUCCESS) {
-        spdlog::critical("Failed to initialize audio buffer: {}", ma_result_description(result));
-        pPayload->audioBuffer.reset();
-        delete pPayload;
-        return false;
+    auto speech = std::make_shared<RenderedSpeech>();
+    speech->format = ma_format_f32;
+    speech->channels = channels;
+    speech->sampleRate = sampleRateOut;
+    speech->frameCount = frameCountOut;
+    speech->pData = pcmData->data();
+    speech->storage = std::move(pcmData);
+    return speech;
+}
+
+// Speech rendered before the devices were opened again at another rate, e.g. taken from the cache. It is rare,
+// so the cheap linear resampler is good enough
+static RenderedSpeechPtr resampleRenderedSpeech(const RenderedSpeech& speech, ma_uint32 sampleRateOut) {
+    std::vector<float> input(speech.frameCount * speech.channels);
+    ConvertSamplesToF32(speech.pData, speech.format, input.data(), input.size(), 1.0f);
+    CResampler resampler(ma_format_f32, speech.channels, speech.sampleRate, sampleRateOut);
+    ma_uint64 frameCountOut = 0;
+    ma_resampler_get_expected_output_frame_count(resampler, speech.frameCount, &frameCountOut);
+    auto pcmData = std::make_shared<std::vector<ma_uint8>>(frameCountOut * speech.channels * sizeof(float));
+    if (resampler.processAudioData(input.data(), speech.frameCount, pcmData->data(), frameCountOut) != MA_SUCCESS) {
+        spdlog::error("Failed to resample speech to {} Hz", sampleRateOut);
+        return nullptr;
     }
+    pcmData->resize(frameCountOut * speech.channels * sizeof(float));
 
-    pPayload->sound = std::make_unique<ma_sound>();
-    result = ma_sound_init_from_data_source(
-        g_AudioEngine, &*pPayload->audioBuffer,
-        MA_SOUND_FLAG_NO_PITCH | MA_SOUND_FLAG_NO_SPATIALIZATION | MA_SOUND_FLAG_ASYNC, nullptr, &*pPayload->sound);
+    auto resampledSpeech = std::make_shared<RenderedSpeech>();
+    resampledSpeech->format = ma_format_f32;
+    resampledSpeech->channels = speech.channels;
+    resampledSpeech->sampleRate = sampleRateOut;
+    resampledSpeech->frameCount = frameCountOut;
+    resampledSpeech->pData = pcmData->data();
+    resampledSpeech->storage = std::move(pcmData);
+    return resampledSpeech;
+}
 
-    if (result != MA_SUCCESS) {
-        spdlog::critical("Failed to initialize sound instance: {}", ma_result_description(result));
-        ma_audio_buffer_uninit(&*pPayload->audioBuffer);
-        pPayload->audioBuffer.reset();
-        pPayload->sound.reset();
-        delete pPayload;
+bool Audio::queueRenderedSpeech(RenderedSpeechPtr speech, std::optional<LatencyClock::time_point> requestTime) {
+    SIM_TRACE_ZONE("Audio::queueRenderedSpeech");
+    if (speech == nullptr) {
         return false;
     }
+    if (speech->frameCount == 0) {
+        return true;
+    }
 
-    sounds.push_back(pPayload);
-    ma_sound_start(&*pPayload->sound);
+    {
+        std::lock_guard lock(m_mutex);
+        if (!openSelectedDevices()) {
+            return false;
+        }
+    }
+    if (speech->sampleRate != m_playbackSampleRate) {
+        SIM_RT_DEBUG("Speech rendered at {} Hz is resampled to {} Hz of the reopened device", speech->sampleRate,
+                     m_playbackSampleRate.load());
+        speech = resampleRenderedSpeech(*speech, m_playbackSampleRate);
+        if (speech == nullptr) {
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard lock(m_payloadsMutex);
+        std::unique_ptr<SoundPayload> payload;
+        if (m_payloadPool.empty()) {
+            payload = std::make_unique<SoundPayload>();
+        } else {
+            payload = std::move(m_payloadPool.back());
+            m_payloadPool.pop_back();
+        }
+        payload->speech = std::move(speech);
+        payload->framesQueued = 0;
+        payload->requestTime = requestTime;
+        m_payloads.push_back(std::move(payload));
+    }
+    m_payloadsCondition.notify_one();
     return true;
 }
 
+void Audio::waitUntilIdle() {
+    while (true) {
+        {
+            std::lock_guard lock(m_mutex);
+            if (!hasPlayingDevice()) {
+                return;
+            }
+        }
+        {
+            // Payloads are popped only after their last frame is in the ring, so both empty means all was read
+            std::lock_guard lock(m_payloadsMutex);
+            if (m_payloads.empty() && m_ring.maxAvailableToRead() == 0) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(AUDIO_FEEDER_WAIT_INTERVAL);
+    }
+
+    // The device still plays the periods it has read from the ring
+    std::this_thread::sleep_for(getDeviceBufferLatency() + std::chrono::milliseconds(1));
+}
+
+void Audio::stop() {
+    {
+        std::lock_guard lock(m_payloadsMutex);
+        m_stoppedPayloadCount = m_payloads.size();
+        m_isStopRequested = true;
+    }
+    m_payloadsCondition.notify_one();
+    SIM_RT_DEBUG("Playback stopped");
+}
+
+bool Audio::isBusy() {
+    std::lock_guard lock(m_payloadsMutex);
+    return !m_payloads.empty() || m_ring.maxAvailableToRead() > 0;
+}
+
+void Audio::feedPlaybackStream(std::stop_token stopToken) {
+    SIM_TRACE_THREAD_NAME("Audio feeder");
+    m_feederBuffer.resize(AUDIO_FEEDER_BLOCK_FRAMES * AUDIO_OUTPUT_CHANNELS);
+    while (!stopToken.stop_requested()) {
+        SoundPayload* pPayload = nullptr;
+        {
+            std::unique_lock lock(m_payloadsMutex);
+            if (!m_payloadsCondition.wait(lock, stopToken,
+                                          [this] { return !m_payloads.empty() || m_isStopRequested; })) {
+                break;
+            }
+            if (m_isStopRequested) {
+                dropStoppedPayloads();
+                continue;
+            }
+            pPayload = m_payloads.front().get();
+        }
+
+        std::unique_lock ringLock(m_ringReadersMutex);
+        const size_t framesFree = m_ring.availableToWrite() / AUDIO_OUTPUT_CHANNELS;
+        if (framesFree == 0) {
+            ringLock.unlock();
+            // The device drains the ring in periods, so waiting for a fraction of its length is enough
+            std::unique_lock lock(m_payloadsMutex);
+            m_payloadsCondition.wait_for(lock, stopToken, AUDIO_FEEDER_WAIT_INTERVAL,
+                                         [this] { return m_isStopRequested; });
+            continue;
+        }
+
+        const ma_uint64 frameCount = std::min<ma_uint64>({static_cast<ma_uint64>(framesFree),
+                                                          pPayload->speech->frameCount - pPayload->framesQueued,
+                                                          static_cast<ma_uint64>(AUDIO_FEEDER_BLOCK_FRAMES)});
+        // Volume is applied here rather than in the device callback, so a change is heard once the ring drains
+        convertToPlaybackFormat(*pPayload, frameCount, m_volume.load(std::memory_order_relaxed), m_feederBuffer.data(),
+                                m_conversionBuffer);
+        const size_t sampleCount = static_cast<size_t>(frameCount) * AUDIO_OUTPUT_CHANNELS;
+        if (pPayload->requestTime.has_value()) {
+            const float* pBegin = m_feederBuffer.data();
+            const float* pEnd = pBegin + sampleCount;
+            const float* pAudible = std::find_if(pBegin, pEnd, [](float sample) {
+                return std::fabs(sample) > AUDIO_SILENCE_THRESHOLD;
+            });
+            if (pAudible != pEnd) {
+                const size_t sampleIndex = pAudible - pBegin;
+                const LatencyMarker marker{m_samplesWritten + sampleIndex - sampleIndex % AUDIO_OUTPUT_CHANNELS,
+                                           *pPayload->requestTime};
+                // The marker is dropped when the callback is too far behind, its utterance is then not measured
+                m_latencyMarkers.write(&marker, 1);
+                pPayload->requestTime.reset();
+            }
+        }
+        m_samplesWritten += m_ring.write(m_feederBuffer.data(), sampleCount);
+        ringLock.unlock();
+        pPayload->framesQueued += frameCount;
+
+        if (pPayload->framesQueued >= pPayload->speech->frameCount) {
+            // The ring holds its own copy of the frames, so the samples can be released right away
+            std::unique_ptr<SoundPayload> finishedPayload;
+            {
+                std::lock_guard lock(m_payloadsMutex);
+                finishedPayload = std::move(m_payloads.front());
+                m_payloads.pop_front();
+                // Already in the ring, so a stop yet to be carried out has one payload less to drop
+                if (m_stoppedPayloadCount > 0) {
+                    --m_stoppedPayloadCount;
+                }
+            }
+            // Freed outside of the lock, so releasing a long render never delays queueing of the next one
+            finishedPayload->speech.reset();
+            std::lock_guard lock(m_payloadsMutex);
+            if (m_payloadPool.size() < AUDIO_PAYLOAD_POOL_SIZE) {
+                m_payloadPool.push_back(std::move(finishedPayload));
+            }
+        }
+    }
+}
+
+void Audio::dropStoppedPayloads() {
+    for (size_t i = 0; i < m_stoppedPayloadCount && !m_payloads.empty(); ++i) {
+        std::unique_ptr<SoundPayload> payload = std::move(m_payloads.front());
+        m_payloads.pop_front();
+        payload->speech.reset();
+        if (m_payloadPool.size() < AUDIO_PAYLOAD_POOL_SIZE) {
+            m_payloadPool.push_back(std::move(payload));
+        }
+    }
+    m_stoppedPayloadCount = 0;
+    m_isStopRequested = false;
+    // Everything written so far belongs to the stopped speech
+    m_stopIndex.store(m_ring.getWriteIndex(), std::memory_order_relaxed);
+    m_stopGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void Audio::readPlaybackStream(OutputDevice& output, float* pSamples, ma_uint32 frameCount) {
+    const size_t sampleCount = static_cast<size_t>(frameCount) * AUDIO_OUTPUT_CHANNELS;
+    const uint32_t stopGeneration = m_stopGeneration.load(std::memory_order_acquire);
+    if (stopGeneration != output.stopGeneration) {
+        output.stopGeneration = stopGeneration;
+        output.stopIndex = m_stopIndex.load(std::memory_order_relaxed);
+        output.stopFadeFramesLeft = output.stopFadeFrameCount;
+        SIM_RT_DEBUG("Fading out stopped audio over {} frames", output.stopFadeFrameCount);
+    }
+
+    // Samples in the ring already have the volume applied
+    size_t samplesRead = 0;
+    size_t samplesSkipped = 0;
+    if (output.stopFadeFramesLeft > 0) {
+        const size_t readIndex = m_ring.getReadIndex(output.reader);
+        samplesRead = readStoppedAudio(output, pSamples, sampleCount);
+        samplesSkipped = m_ring.getReadIndex(output.reader) - readIndex - samplesRead;
+    } else if (output.pPrimary != nullptr) {
+        samplesRead = readFollowingPrimary(output, pSamples, frameCount);
+    } else {
+        samplesRead = m_ring.read(output.reader, pSamples, sampleCount);
+    }
+    std::fill(pSamples + samplesRead, pSamples + sampleCount, 0.0f);
+    if (output.pPrimary == nullptr) {
+        m_samplesRead += samplesRead + samplesSkipped;
+        consumeLatencyMarkers(samplesSkipped == 0);
+    }
+}
+
+size_t Audio::readStoppedAudio(OutputDevice& output, float* pSamples, size_t sampleCount) {
+    // The reader is past the stop already when it read right after the feeder carried the stop out
+    const size_t samplesToStop = output.stopIndex - m_ring.getReadIndex(output.reader);
+    if (samplesToStop > m_ring.capacity()) {
+        output.stopFadeFramesLeft = 0;
+        return 0;
+    }
+    const size_t fadeSampleCount = output.stopFadeFramesLeft * AUDIO_OUTPUT_CHANNELS;
+    const size_t samplesRead =
+        m_ring.read(output.reader, pSamples, std::min({sampleCount, samplesToStop, fadeSampleCount}));
+    for (size_t frame = 0; frame < samplesRead / AUDIO_OUTPUT_CHANNELS; ++frame) {
+        const float gain = (float)(output.stopFadeFramesLeft - frame) / output.stopFadeFrameCount;
+        for (size_t channel = 0; channel < AUDIO_OUTPUT_CHANNELS; ++channel) {
+            pSamples[frame * AUDIO_OUTPUT_CHANNELS + channel] *= gain;
+        }
+    }
+    output.stopFadeFramesLeft -= samplesRead / AUDIO_OUTPUT_CHANNELS;
+    if (output.stopFadeFramesLeft == 0 || samplesRead == samplesToStop) {
+        // Faded out, the rest of the stopped audio is never played
+        m_ring.skip(output.reader, samplesToStop - samplesRead);
+        output.stopFadeFramesLeft = 0;
+    }
+    return samplesRead;
+}
+
+void Audio::consumeLatencyMarkers(bool isPlayed) {
+    while (true) {
+        if (!m_pendingLatencyMarker.has_value()) {
+            LatencyMarker marker;
+            if (m_latencyMarkers.read(&marker, 1) == 0) {
+                return;
+            }
+            m_pendingLatencyMarker = marker;
+        }
+        if (m_pendingLatencyMarker->samplePosition >= m_samplesRead) {
+            return;
+        }
+        if (isPlayed) {
+            g_LatencyTracker.record(LatencyStage::FirstFrame, m_pendingLatencyMarker->requestTime);
+        }
+        m_pendingLatencyMarker.reset();
+    }
+}
+
+size_t Audio::readFollowingPrimary(OutputDevice& output, float* pSamples, ma_uint32 frameCount) {
+    const size_t sampleCount = static_cast<size_t>(frameCount) * AUDIO_OUTPUT_CHANNELS;
+    const size_t backlog = m_ring.availableToRead(output.reader) / AUDIO_OUTPUT_CHANNELS;
+    if (output.pPrimary->isLost || backlog == 0) {
+        return m_ring.read(output.reader, pSamples, sampleCount);
+    }
+    // Clocks of two devices never run at exactly the same rate. Correcting the difference by a single frame per
+    // period keeps the devices in sync without audible gaps, and it is far more than real clocks drift apart
+    const auto primaryBacklog = m_ring.availableToRead(output.pPrimary->reader) / AUDIO_OUTPUT_CHANNELS;
+    const auto drift = static_cast<ptrdiff_t>(backlog) - static_cast<ptrdiff_t>(primaryBacklog);
+    const auto driftTolerance = static_cast<ptrdiff_t>(output.driftToleranceFrames);
+    if (drift > driftTolerance) {
+        // This device plays slower than the primary one, so it drops a frame
+        SIM_RT_TRACE("Secondary device is {} frames behind the primary one, dropping a frame", drift);
+        m_ring.skip(output.reader, AUDIO_OUTPUT_CHANNELS);
+    } else if (drift < -driftTolerance && frameCount > 1) {
+        // This device plays faster, so it reads a frame less and plays the last one twice
+        SIM_RT_TRACE("Secondary device is {} frames ahead of the primary one, repeating a frame", -drift);
+        const size_t samplesRead = m_ring.read(output.reader, pSamples, sampleCount - AUDIO_OUTPUT_CHANNELS);
+        if (samplesRead < sampleCount - AUDIO_OUTPUT_CHANNELS) {
+            return samplesRead;
+        }
+        std::copy_n(pSamples + samplesRead - AUDIO_OUTPUT_CHANNELS, AUDIO_OUTPUT_CHANNELS, pSamples + samplesRead);
+        return sampleCount;
+    }
+    return m_ring.read(output.reader, pSamples, sampleCount);
+}
+
+void Audio::convertToPlaybackFormat(const SoundPayload& payload, ma_uint64 frameCount, float gain, float* pOutput,
+                                    std::vector<float>& conversionBuffer) {
+    const RenderedSpeech& speech = *payload.speech;
+    const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(speech.format, speech.channels);
+    const ma_uint8* pInput = speech.pData + payload.framesQueued * bytesPerFrame;
+    const size_t sampleCount = static_cast<size_t>(frameCount * speech.channels);
+    if (speech.channels == AUDIO_OUTPUT_CHANNELS) {
+        ConvertSamplesToF32(pInput, speech.format, pOutput, sampleCount, gain);
+        return;
+    }
+
+    conversionBuffer.resize(sampleCount);
+    ConvertSamplesToF32(pInput, speech.format, conversionBuffer.data(), sampleCount, gain);
+    for (ma_uint64 frame = 0; frame < frameCount; ++frame) {
+        const float* pFrame = &conversionBuffer[frame * speech.channels];
+        // Mono is duplicated to both channels, anything wider keeps its first two channels
+        pOutput[frame * AUDIO_OUTPUT_CHANNELS] = pFrame[0];
+        pOutput[frame * AUDIO_OUTPUT_CHANNELS + 1] = speech.channels == 1 ? pFrame[0] : pFrame[1];
+    }
+}
+
 float Audio::getVolume() {
-    return ma_engine_get_volume(g_AudioEngine);
+    return m_volume.load(std::memory_order_relaxed);
 }
 
 void Audio::setVolume(const float volume) {
-    ma_engine_set_volume(g_AudioEngine, volume);
+    m_volume.store(volume, std::memory_order_relaxed);
+}
+
+AudioResampler Audio::getResampler() {
+    return m_resamplerType;
+}
+
+void Audio::setResampler(AudioResampler resampler) {
+    m_resamplerType = resampler;
+}
+
+void Audio::setDeviceConfig(const AudioDeviceConfig& deviceConfig) {
+    std::lock_guard lock(m_mutex);
+    m_deviceConfig = deviceConfig;
+    m_isDeviceConfigChanged = true;
+}
+
+ma_uint32 Audio::getPlaybackSampleRate() {
+    std::lock_guard lock(m_mutex);
+    openSelectedDevices();
+    return m_playbackSampleRate;
+}
+
+bool Audio::openSelectedDevices() {
+    if (!m_deviceRegistry.contains(m_selectedDeviceID)) {
+        auto deviceID = m_deviceRegistry.getDeviceId(0);
+        if (!deviceID.has_value()) {
+            spdlog::error("No playback devices are available");
+            return false;
+        }
+        spdlog::warn("Selected audio device is unavailable. Falling back to index 0.");
+        m_selectedDeviceID = *deviceID;
+    }
+    updateDevice();
+    return true;
+}
+
+std::chrono::microseconds Audio::getDeviceBufferLatency() {
+    std::lock_guard lock(m_mutex);
+    std::chrono::microseconds bufferLatency{0};
+    for (const auto& output : m_devices) {
+        bufferLatency = std::max(bufferLatency, output->device->getBufferLatency());
+    }
+    return bufferLatency;
+}
+
+void Audio::openDevices(const std::vector<ma_device_id>& deviceIDs) {
+    std::lock_guard lock(m_ringReadersMutex);
+    for (const ma_device_id& deviceID : deviceIDs) {
+        const bool isPrimary = m_devices.empty();
+        if (!isPrimary) {
+            const bool isOpen = std::ranges::any_of(m_devices, [&](const auto& output) {
+                return ma_device_id_equal(&output->id, &deviceID) == MA_TRUE;
+            });
+            if (isOpen || !m_deviceRegistry.contains(deviceID)) {
+                spdlog::warn("Secondary audio device is {}, it is skipped", isOpen ? "already playing" : "unavailable");
+                continue;
+            }
+        }
+        auto output = std::make_unique<OutputDevice>();
+        output->pAudio = this;
+        output->id = deviceID;
+        output->pPrimary = isPrimary ? nullptr : m_devices.front().get();
+        // Stops requested before the device was opened are carried out by the feeder already
+        output->stopGeneration = m_stopGeneration.load(std::memory_order_acquire);
+        try {
+            output->device = std::make_unique<CDevice>(&output->id, isPrimary ? 0 : m_playbackSampleRate.load(),
+                                                       m_deviceConfig, &Audio::audioDataCallback,
+                                                       &Audio::deviceNotificationCallback, output.get());
+        } catch (const std::runtime_error&) {
+            if (isPrimary) {
+                throw;
+            }
+            // The primary device plays on, the secondary one is tried again when the devices are opened next time
+            spdlog::warn("Secondary audio device failed to open, it is skipped");
+            continue;
+        }
+        output->reader = *m_ring.addReader();
+        output->pTraceBuffer = g_TraceRecorder.acquireThreadBuffer("Audio callback");
+        output->pLogRing = g_RtLogger.acquireThreadRing();
+        if (isPrimary) {
+            // Audio already in the ring or queued keeps the rate it was rendered at, only a device switch plays
+            // the little of it left at another rate
+            m_playbackSampleRate = output->device->getSampleRate();
+        }
+        output->stopFadeFrameCount = std::max<size_t>(
+            1, m_playbackSampleRate * std::chrono::duration<double>(AUDIO_STOP_FADE_DURATION).count());
+        if (!isPrimary) {
+            output->driftToleranceFrames =
+                output->pPrimary->device->getPeriodSizeInFrames() + output->device->getPeriodSizeInFrames();
+        }
+        m_devices.push_back(std::move(output));
+    }
+    // Started once all of them are open, so they begin reading the stream together
+    for (const auto& output : m_devices) {
+        ma_device_start(*output->device);
+    }
+}
+
+void Audio::closeDevices() {
+    m_isClosingDevice = true;
+    for (const auto& output : m_devices) {
+        output->device.reset();
+    }
+    m_isClosingDevice = false;
+    std::lock_guard lock(m_ringReadersMutex);
+    for (const auto& output : m_devices) {
+        m_ring.removeReader(output->reader);
+        // Their callback threads have exited with the devices
+        g_TraceRecorder.releaseThreadBuffer(output->pTraceBuffer);
+        g_RtLogger.releaseThreadRing(output->pLogRing);
+    }
+    m_devices.clear();
+}
+
+bool Audio::hasPlayingDevice() const {
+    return std::ranges::any_of(m_devices, [](const auto& output) { return !output->isLost; });
 }
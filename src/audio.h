@@ -1,21 +1,74 @@
 #pragma once
 
+#include "broadcastRingBuffer.h"
+#include "deviceRegistry.h"
+#include "latencyTracker.h"
+#include "polyphaseResampler.h"
+#include "rtLogger.h"
 #include "singleton.h"
+#include "spscRingBuffer.h"
+#include "traceRecorder.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <miniaudio.h>
+#include <mutex>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
+#include <stop_token>
+#include <thread>
 #include <vector>
 
+// Rate of the playback stream until the primary device is opened at its native rate
 inline constexpr ma_uint32 AUDIO_DEFAULT_SAMPLE_RATE = 48000;
+// The playback stream is always interleaved stereo f32, miniaudio converts it to the device format
+inline constexpr ma_uint32 AUDIO_OUTPUT_CHANNELS = 2;
+inline constexpr size_t AUDIO_RING_BUFFER_FRAMES = 8192;
+// Devices playing the same speech at once, e.g. a virtual cable for a voice chat and local speakers
+inline constexpr size_t AUDIO_MAX_OUTPUT_DEVICES = 4;
+inline constexpr size_t AUDIO_FEEDER_BLOCK_FRAMES = 1024;
+inline constexpr std::chrono::milliseconds AUDIO_FEEDER_WAIT_INTERVAL{10};
+// Finished payload objects kept for reuse, enough for a long text streamed sentence by sentence
+inline constexpr size_t AUDIO_PAYLOAD_POOL_SIZE = 32;
+// Utterances whose first audible frame the device callback has yet to reach
+inline constexpr size_t AUDIO_LATENCY_MARKER_CAPACITY = 16;
+// Quieter than the least significant bit of 16-bit audio, so leading silence of a voice is not counted as audio
+inline constexpr float AUDIO_SILENCE_THRESHOLD = 1.0f / 65536.0f;
+// Long enough for stopped speech not to click, short enough not to be heard as a fade
+inline constexpr std::chrono::milliseconds AUDIO_STOP_FADE_DURATION{5};
+
+// Algorithm used to bring speech to the playback rate. Values are stored in the speech disk cache
+enum class AudioResampler : uint32_t {
+    Linear = 0,
+    // Windowed-sinc, falls back to linear for rate ratios it has no table for
+    Sinc = 1,
+};
+
+// How the playback device is opened. Zero period values leave the choice to miniaudio and its performance profile
+struct AudioDeviceConfig {
+    // Shorter periods and fewer of them, at the cost of more frequent callbacks
+    bool isLowLatency = false;
+    ma_uint32 periodSizeInFrames = 0;
+    ma_uint32 periods = 0;
+    // Exclusive mode bypasses the system mixer where the backend supports it, otherwise shared mode is used
+    bool isExclusive = false;
+};
 
-struct DeviceInfo {
-    ma_device_id id;
-    std::string_view name;
-    bool isDefault;
+// What happens when speech is queued while another one is still playing
+enum class PlaybackPolicy {
+    // Played right after the current one without a gap
+    Queue,
+    // The current speech fades out and everything queued after it is dropped
+    Interrupt,
+    // The new speech is dropped
+    DropIfBusy,
 };
 
 // Thanks to @m1maker for this idea of wrapping miniaudio in C++ way
@@ -23,10 +76,16 @@ class CAudioContext {
   public:
     CAudioContext() : context(nullptr) {
         context = std::make_unique<ma_context>();
+#ifdef SIM_AUDIO_NULL_BACKEND
+        // Benchmarks play into a device which consumes audio in real time without any hardware
+        ma_backend backends[] = {ma_backend_null};
+        ma_result result = ma_context_init(backends, 1, nullptr, &*context);
+#else
         ma_result result = ma_context_init(nullptr, 0, nullptr, &*context);
+#endif
         if (result != MA_SUCCESS) {
             spdlog::error("Failed to initialize miniaudio context: {}", ma_result_description(result));
-            throw std::exception("Failed to initialize miniaudio context");
+            throw std::runtime_error("Failed to initialize miniaudio context");
         }
     }
 
@@ -43,57 +102,45 @@ class CAudioContext {
 
 #define g_AudioContext CSingleton<CAudioContext>::GetInstance()
 
-/*
-This declaration is made to free resources in the right order.
-We deinitialize SoundPayloads first, then AudioEngine.
-*/
-static void freeAllSounds();
-
-class CAudioEngine {
-  public:
-    CAudioEngine() : engine(nullptr) {
-        engine = std::make_unique<ma_engine>();
-        ma_engine_config config = ma_engine_config_init();
-        config.noDevice = MA_TRUE;
-        config.channels = 2;
-        config.sampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
-        config.pContext = g_AudioContext;
-        ma_result result = ma_engine_init(&config, &*engine);
-        if (result != MA_SUCCESS) {
-            spdlog::error("Failed to initialize miniaudio engine: {}", ma_result_description(result));
-            throw std::exception("Failed to initialize miniaudio audio engine");
-        }
-    }
-
-    ~CAudioEngine() {
-        freeAllSounds();
-        ma_engine_uninit(&*engine);
-        engine.reset();
-    }
-
-    operator ma_engine*() { return &*engine; }
-
-  private:
-    std::unique_ptr<ma_engine> engine;
-};
-
-#define g_AudioEngine CSingleton<CAudioEngine>::GetInstance()
-
 class CDevice {
   public:
-    CDevice(ma_device_id* deviceID, ma_device_data_proc dataCallback) : device(nullptr) {
+    // Zero sample rate opens the device at its native rate, so the backend does not resample
+    CDevice(ma_device_id* deviceID, ma_uint32 sampleRate, const AudioDeviceConfig& deviceConfig,
+            ma_device_data_proc dataCallback, ma_device_notification_proc notificationCallback, void* pUserData)
+        : device(nullptr) {
         device = std::make_unique<ma_device>();
         ma_device_config config = ma_device_config_init(ma_device_type_playback);
         config.playback.pDeviceID = deviceID;
-        config.sampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
+        config.playback.format = ma_format_f32;
+        config.playback.channels = AUDIO_OUTPUT_CHANNELS;
+        config.sampleRate = sampleRate;
+        config.performanceProfile =
+            deviceConfig.isLowLatency ? ma_performance_profile_low_latency : ma_performance_profile_conservative;
+        config.periodSizeInFrames = deviceConfig.periodSizeInFrames;
+        config.periods = deviceConfig.periods;
+        config.playback.shareMode = deviceConfig.isExclusive ? ma_share_mode_exclusive : ma_share_mode_shared;
 
         config.dataCallback = dataCallback;
-        config.pUserData = g_AudioEngine;
+        config.notificationCallback = notificationCallback;
+        config.pUserData = pUserData;
         ma_result result = ma_device_init(g_AudioContext, &config, &*device);
+        if (result != MA_SUCCESS && deviceConfig.isExclusive) {
+            spdlog::warn("Exclusive mode is unavailable ({}), falling back to shared mode",
+                         ma_result_description(result));
+            config.playback.shareMode = ma_share_mode_shared;
+            result = ma_device_init(g_AudioContext, &config, &*device);
+        }
         if (result != MA_SUCCESS) {
             spdlog::error("Failed to initialize audio device: {}", ma_result_description(result));
-            throw std::exception();
+            throw std::runtime_error("Failed to initialize audio device");
         }
+        spdlog::debug("Audio device {} plays {} Hz with {} periods of {} frames at {} Hz in {} mode, {:.1f} ms of "
+                      "buffering",
+                      ma_get_backend_name(device->pContext->backend), device->sampleRate,
+                      device->playback.internalPeriods, device->playback.internalPeriodSizeInFrames,
+                      device->playback.internalSampleRate,
+                      device->playback.shareMode == ma_share_mode_exclusive ? "exclusive" : "shared",
+                      std::chrono::duration<double, std::milli>(getBufferLatency()).count());
     }
 
     ~CDevice() {
@@ -103,6 +150,30 @@ class CDevice {
 
     operator ma_device*() { return &*device; }
 
+    // Rate the callback is asked for
+    ma_uint32 getSampleRate() const { return device->sampleRate; }
+
+    // Frames the callback is asked for at once, at the rate of the playback stream
+    ma_uint32 getPeriodSizeInFrames() const {
+        const ma_uint32 internalSampleRate = device->playback.internalSampleRate;
+        if (internalSampleRate == 0) {
+            return device->playback.internalPeriodSizeInFrames;
+        }
+        return static_cast<ma_uint32>(static_cast<uint64_t>(device->playback.internalPeriodSizeInFrames) *
+                                      device->sampleRate / internalSampleRate);
+    }
+
+    // Time the device takes to play the periods it has already pulled from the callback
+    std::chrono::microseconds getBufferLatency() const {
+        const ma_uint32 sampleRate = device->playback.internalSampleRate;
+        if (sampleRate == 0) {
+            return std::chrono::microseconds(0);
+        }
+        const uint64_t bufferedFrames =
+            static_cast<uint64_t>(device->playback.internalPeriodSizeInFrames) * device->playback.internalPeriods;
+        return std::chrono::microseconds(bufferedFrames * 1000000 / sampleRate);
+    }
+
   private:
     std::unique_ptr<ma_device> device;
 };
@@ -117,7 +188,7 @@ class CResampler {
         ma_result result = ma_resampler_init(&config, nullptr, &*resampler);
         if (result != MA_SUCCESS) {
             spdlog::error("Failed to initialize resampler: {}", ma_result_description(result));
-            throw std::exception();
+            throw std::runtime_error("Failed to initialize resampler");
         }
     }
 
@@ -151,48 +222,153 @@ class CResampler {
     friend class Audio;
 };
 
+// Speech resampled to the playback rate. It is immutable, so the cache and the playback queue can share it
+struct RenderedSpeech {
+    ma_format format;
+    ma_uint32 channels;
+    ma_uint32 sampleRate;
+    ma_uint64 frameCount;
+    // Samples live in whatever the storage owns, e.g. a vector or a file mapping
+    const ma_uint8* pData;
+    std::shared_ptr<const void> storage;
+
+    size_t sizeInBytes() const { return frameCount * ma_get_bytes_per_frame(format, channels); }
+};
+
+using RenderedSpeechPtr = std::shared_ptr<const RenderedSpeech>;
+
 class Audio {
   public:
-    Audio() : m_device(nullptr), m_hasCurrentDevice(false) {
-        auto devices = getDevicesList();
-        if (devices.empty()) {
+    Audio()
+        : m_ring(AUDIO_RING_BUFFER_FRAMES * AUDIO_OUTPUT_CHANNELS), m_latencyMarkers(AUDIO_LATENCY_MARKER_CAPACITY),
+          m_feeder([this](std::stop_token stopToken) { feedPlaybackStream(stopToken); }) {
+        // Constructed first, so they outlive the device callback which records into them
+        (void)g_LatencyTracker;
+        (void)g_TraceRecorder;
+        auto deviceID = m_deviceRegistry.getDeviceId(0);
+        if (!deviceID.has_value()) {
             spdlog::warn("No audio devices found during Audio initialization");
             std::memset(&m_selectedDeviceID, 0, sizeof(m_selectedDeviceID));
-            std::memset(&m_currentDeviceID, 0, sizeof(m_currentDeviceID));
             return;
         }
-        m_selectedDeviceID = devices[0].id;
-        std::memset(&m_currentDeviceID, 0, sizeof(m_currentDeviceID));
+        m_selectedDeviceID = *deviceID;
+    }
+    ~Audio() {
+        // The feeder and the device callback use the ring buffer, so both have to stop before it is destroyed
+        m_feeder.request_stop();
+        if (m_feeder.joinable()) {
+            m_feeder.join();
+        }
+        closeDevices();
     }
-    ~Audio() = default;
 
     std::vector<DeviceInfo> getDevicesList();
+    // Enumerates devices again, for example after a device was plugged in
+    std::vector<DeviceInfo> refreshDevicesList();
     void selectDevice(size_t deviceIndex);
+    // Devices which play everything the selected one does. Speech is rendered and converted once for all of them
+    void selectSecondaryDevices(const std::vector<size_t>& deviceIndices);
+    // Queues the data after everything queued before, so consecutive calls are played back without gaps
     bool playAudioData(const int channels, const int sampleRate, const int bitsPerSample, const uint64_t bufferSize,
                        const void* buffer);
+    // Takes ownership of the malloc-allocated buffer. At the playback rate it is played in place, otherwise resampled
+    RenderedSpeechPtr renderAudioData(const int channels, const int sampleRate, const int bitsPerSample,
+                                      const uint64_t bufferSize, const void* buffer);
+    // With the request time the latency to the first audible frame of the speech is recorded
+    bool queueRenderedSpeech(RenderedSpeechPtr speech, std::optional<LatencyClock::time_point> requestTime = {});
+    // Blocks until everything queued so far has been played, returns at once if there is no working device
+    void waitUntilIdle();
+    // Fades out the speech playing and drops everything queued, the devices go silent within a period
+    void stop();
+    // Whether speech is queued or still in the playback stream
+    bool isBusy();
     float getVolume();
     void setVolume(const float volume);
+    AudioResampler getResampler();
+    void setResampler(AudioResampler resampler);
+    // The device is opened again with the configuration before the next speech is played
+    void setDeviceConfig(const AudioDeviceConfig& deviceConfig);
+    // Buffering of the slowest open device, zero before the first speech opens them
+    std::chrono::microseconds getDeviceBufferLatency();
+    // Native rate of the primary device, which speech is resampled to once. Opens the devices if they are not open
+    ma_uint32 getPlaybackSampleRate();
 
   private:
-    std::unique_ptr<CDevice> m_device;
+    // An open playback device with its own reader of the playback stream
+    struct OutputDevice {
+        Audio* pAudio = nullptr;
+        ma_device_id id;
+        size_t reader = 0;
+        // Secondary devices follow the reader of the primary one, the feeder keeps the stream at its pace
+        const OutputDevice* pPrimary = nullptr;
+        // Backlog difference to the primary device accepted before correcting it, the callbacks of both devices
+        // run at their own times, so it is up to a period of each
+        size_t driftToleranceFrames = 0;
+        // The stop the callback carried out last, and the end of the stopped audio in the ring while it fades out
+        uint32_t stopGeneration = 0;
+        size_t stopIndex = 0;
+        size_t stopFadeFrameCount = 0;
+        size_t stopFadeFramesLeft = 0;
+        std::atomic<bool> isLost = false;
+        // Acquired before the device starts, so its callback thread never claims them itself
+        TraceRecorder::ThreadBuffer* pTraceBuffer = nullptr;
+        RtLogger::ThreadRing* pLogRing = nullptr;
+        std::unique_ptr<CDevice> device;
+    };
+
+    // The first one is the primary device
+    std::vector<std::unique_ptr<OutputDevice>> m_devices;
     std::unique_ptr<CResampler> m_resampler;
+    std::unique_ptr<PolyphaseResampler> m_polyphaseResampler;
+    std::vector<float> m_polyphaseInput;
+    std::atomic<AudioResampler> m_resamplerType = AudioResampler::Linear;
     ma_device_id m_selectedDeviceID;
-    ma_device_id m_currentDeviceID;
-    bool m_hasCurrentDevice;
-    std::vector<DeviceInfo> m_lastDevicesList;
+    std::vector<ma_device_id> m_secondaryDeviceIDs;
+    // Primary and secondary devices requested when the devices were opened last
+    std::vector<ma_device_id> m_openedDeviceIDs;
+    AudioDeviceConfig m_deviceConfig;
+    bool m_isDeviceConfigChanged = false;
+    // Secondary devices are opened at this rate too and resample on their own when their native rate differs
+    std::atomic<ma_uint32> m_playbackSampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
+    CDeviceRegistry m_deviceRegistry;
+    // Set by the notification callback when the backend stops a device on its own, e.g. when it is unplugged
+    std::atomic<bool> m_isDeviceLost = false;
+    std::atomic<bool> m_isClosingDevice = false;
+    // Playback is driven by the speech worker thread while device selection comes from the UI thread
+    std::mutex m_mutex;
 
     void updateDevice() {
-        if (m_hasCurrentDevice && ma_device_id_equal(&m_currentDeviceID, &m_selectedDeviceID)) {
+        SIM_TRACE_ZONE("Audio::updateDevice");
+        std::vector<ma_device_id> deviceIDs{m_selectedDeviceID};
+        deviceIDs.insert(deviceIDs.end(), m_secondaryDeviceIDs.begin(), m_secondaryDeviceIDs.end());
+        if (!m_devices.empty() && !m_isDeviceLost && !m_isDeviceConfigChanged &&
+            std::ranges::equal(deviceIDs, m_openedDeviceIDs, [](const ma_device_id& first, const ma_device_id& second) {
+                return ma_device_id_equal(&first, &second) == MA_TRUE;
+            })) {
             return;
         }
-        spdlog::debug("Initializing new audio device");
-        m_device = std::make_unique<CDevice>(&m_selectedDeviceID, &Audio::audioDataCallback);
-        ma_device_start(*m_device);
-        m_currentDeviceID = m_selectedDeviceID;
-        m_hasCurrentDevice = true;
+        spdlog::debug("Initializing {} audio devices", deviceIDs.size());
+        // The old devices are uninitialized before the new ones start, so no reader is added while another reads
+        closeDevices();
+        m_isDeviceLost = false;
+        m_isDeviceConfigChanged = false;
+        m_openedDeviceIDs = deviceIDs;
+        openDevices(deviceIDs);
     }
 
+    // Falls back to the first device when the selected one is gone, returns false without any device
+    bool openSelectedDevices();
+    void openDevices(const std::vector<ma_device_id>& deviceIDs);
+    void closeDevices();
+    bool hasPlayingDevice() const;
+
+    // Returns nullptr when the polyphase resampler does not support the rates, the caller keeps the buffer
+    RenderedSpeechPtr renderWithPolyphaseResampler(ma_format format, ma_uint32 channels, ma_uint32 sampleRate,
+                                                   ma_uint32 sampleRateOut, ma_uint64 frameCountIn,
+                                                   const void* buffer);
+
     void updateResampler(ma_format format, ma_uint32 channels, ma_uint32 sampleRateIn, ma_uint32 sampleRateOut) {
+        SIM_TRACE_ZONE("Audio::updateResampler");
         if (m_resampler == nullptr || m_resampler->resampler->format != format ||
             m_resampler->resampler->channels != channels) {
             m_resampler = std::make_unique<CResampler>(format, channels, sampleRateIn, sampleRateOut);
@@ -205,64 +381,107 @@ class Audio {
         ma_result result = m_resampler->setRate(sampleRateIn, sampleRateOut);
         if (result != MA_SUCCESS) {
             spdlog::error("Failed to set sample rate: {}", ma_result_description(result));
-            throw std::exception();
+            throw std::runtime_error("Failed to set resampler rate");
         }
     }
 
     static void audioDataCallback(ma_device* pDevice, void* pOutput, const void* pInput, const ma_uint32 frameCount) {
-        auto engine = (ma_engine*)pDevice->pUserData;
-        if (engine == nullptr) {
+        auto* output = (OutputDevice*)pDevice->pUserData;
+        if (output == nullptr) {
             return;
         }
-        ma_engine_read_pcm_frames(engine, pOutput, frameCount, nullptr);
+        SIM_TRACE_BIND_THREAD_BUFFER(output->pTraceBuffer);
+        g_RtLogger.bindThreadRing(output->pLogRing);
+        SIM_TRACE_ZONE("Audio::audioDataCallback");
+        output->pAudio->readPlaybackStream(*output, (float*)pOutput, frameCount);
     }
 
-    struct SoundPayload {
-        std::unique_ptr<ma_sound> sound;
-        std::unique_ptr<ma_audio_buffer> audioBuffer;
-        std::vector<ma_uint8> pcmData;
-
-        ~SoundPayload() {
-            if (sound != nullptr) {
-                ma_sound_uninit(&*sound);
-                sound.reset();
-            }
-
-            if (audioBuffer != nullptr) {
-                ma_audio_buffer_uninit(&*audioBuffer);
-                audioBuffer.reset();
-            }
+    static void deviceNotificationCallback(const ma_device_notification* pNotification) {
+        auto* output = (OutputDevice*)pNotification->pDevice->pUserData;
+        if (output == nullptr) {
+            return;
+        }
+        Audio* audio = output->pAudio;
+        switch (pNotification->type) {
+            case ma_device_notification_type_stopped:
+                if (audio->m_isClosingDevice) {
+                    break;
+                }
+                SIM_RT_WARN("Audio device stopped unexpectedly, primary: {}", output->pPrimary == nullptr);
+                output->isLost = true;
+                {
+                    // Its reader stopped moving, without removing it the feeder would wait for it forever
+                    std::lock_guard lock(audio->m_ringReadersMutex);
+                    audio->m_ring.removeReader(output->reader);
+                }
+                audio->m_isDeviceLost = true;
+                audio->m_deviceRegistry.invalidate();
+                break;
+            case ma_device_notification_type_rerouted:
+            case ma_device_notification_type_interruption_began:
+                SIM_RT_DEBUG("Audio device was rerouted or interrupted, notification: {}", (int)pNotification->type);
+                audio->m_deviceRegistry.invalidate();
+                break;
+            default:
+                break;
         }
+    }
+
+    // Rendered speech waiting to be converted into the playback stream
+    struct SoundPayload {
+        RenderedSpeechPtr speech;
+        ma_uint64 framesQueued = 0;
+        // Set until the first audible frame is written to the ring
+        std::optional<LatencyClock::time_point> requestTime;
     };
 
-    std::vector<SoundPayload*> sounds;
+    // Position of the first audible sample of an utterance in the playback stream
+    struct LatencyMarker {
+        uint64_t samplePosition;
+        LatencyClock::time_point requestTime;
+    };
 
-  public:
-    void freeSounds(bool onlyUnused = true) {
-        int counter = 0;
-        auto it = std::remove_if(sounds.begin(), sounds.end(), [&](SoundPayload* sound) {
-            if (sound != nullptr && (!onlyUnused || (sound->sound != nullptr && ma_sound_at_end(&*sound->sound)))) {
-                delete sound;
-                counter++;
-                return true;
-            }
-            return false;
-        });
-
-        sounds.erase(it, sounds.end()); // Erase the removed elements from the vector
-
-        if (counter > 0) {
-            spdlog::debug("Sounds freed: {}", counter);
-        }
-    }
+    // Written by the feeder thread only and read by the callback of every device
+    BroadcastRingBuffer<float, AUDIO_MAX_OUTPUT_DEVICES> m_ring;
+    // Held by the feeder while it writes and whenever readers are added or removed, the callbacks never take it
+    std::mutex m_ringReadersMutex;
+    // Read by the callback of the primary device only
+    SpscRingBuffer<LatencyMarker> m_latencyMarkers;
+    // Samples that went through the ring, counted by the feeder and the primary device on their own
+    uint64_t m_samplesWritten = 0;
+    uint64_t m_samplesRead = 0;
+    // Used by the callback of the primary device only
+    std::optional<LatencyMarker> m_pendingLatencyMarker;
+    std::atomic<float> m_volume = 1.0f;
+    std::mutex m_payloadsMutex;
+    std::condition_variable_any m_payloadsCondition;
+    std::deque<std::unique_ptr<SoundPayload>> m_payloads;
+    // A stop is carried out by the feeder, which drops the payloads queued before it
+    bool m_isStopRequested = false;
+    size_t m_stoppedPayloadCount = 0;
+    // Published by the feeder for the callbacks: the ring position where the stopped audio ends, then the counter
+    std::atomic<size_t> m_stopIndex = 0;
+    std::atomic<uint32_t> m_stopGeneration = 0;
+    // Recycled payloads, so queueing speech does not allocate once the pool is warm
+    std::vector<std::unique_ptr<SoundPayload>> m_payloadPool;
+    std::vector<float> m_conversionBuffer;
+    std::vector<float> m_feederBuffer;
+    // Declared last so the thread starts after everything it uses is constructed
+    std::jthread m_feeder;
+
+    void feedPlaybackStream(std::stop_token stopToken);
+    void dropStoppedPayloads();
+    void readPlaybackStream(OutputDevice& output, float* pSamples, ma_uint32 frameCount);
+    size_t readStoppedAudio(OutputDevice& output, float* pSamples, size_t sampleCount);
+    // Markers of stopped speech are dropped instead of recorded
+    void consumeLatencyMarkers(bool isPlayed);
+    size_t readFollowingPrimary(OutputDevice& output, float* pSamples, ma_uint32 frameCount);
+    static void convertToPlaybackFormat(const SoundPayload& payload, ma_uint64 frameCount, float gain, float* pOutput,
+                                        std::vector<float>& conversionBuffer);
 };
 
 #define g_Audio CSingleton<Audio>::GetInstance()
 
-static void freeAllSounds() {
-    g_Audio.freeSounds(false);
-}
-
 inline ma_format determineFormat(int bitsPerSample) {
     switch (bitsPerSample) {
         case 8:
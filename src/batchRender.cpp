@@ -0,0 +1,150 @@
+#include "batchRender.h"
+
+#include "audio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <miniaudio.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BatchPhrase {
+    std::filesystem::path outputPath;
+    std::string text;
+};
+
+// Lines are either "text" or "name<TAB>text". Unnamed phrases are numbered by their line
+static std::optional<std::vector<BatchPhrase>> readPhraseList(const std::filesystem::path& listPath,
+                                                               const std::filesystem::path& outputDir) {
+    std::ifstream file(listPath);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::vector<BatchPhrase> phrases;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        const size_t tabPosition = line.find('\t');
+        if (tabPosition == std::string::npos) {
+            phrases.push_back({outputDir / std::format("{:05}.wav", lineNumber), line});
+        } else {
+            phrases.push_back({outputDir / (line.substr(0, tabPosition) + ".wav"), line.substr(tabPosition + 1)});
+        }
+    }
+    return phrases;
+}
+
+static bool writeWavFile(const std::filesystem::path& path, const SynthesizedSpeech& speech) {
+    const ma_format format = determineFormat(speech.bitsPerSample);
+    if (format == ma_format_unknown || speech.channels <= 0 || speech.sampleRate <= 0) {
+        spdlog::error("Unsupported audio format: channels={}, sampleRate={}, bitsPerSample={}", speech.channels,
+                      speech.sampleRate, speech.bitsPerSample);
+        return false;
+    }
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, format, (ma_uint32)speech.channels,
+                                                      (ma_uint32)speech.sampleRate);
+    ma_encoder encoder;
+#ifdef _WIN32
+    ma_result result = ma_encoder_init_file_w(path.c_str(), &config, &encoder);
+#else
+    ma_result result = ma_encoder_init_file(path.c_str(), &config, &encoder);
+#endif
+    if (result != MA_SUCCESS) {
+        spdlog::error("Failed to create {}: {}", path.string(), ma_result_description(result));
+        return false;
+    }
+    const ma_uint64 frameCount = speech.bufferSize / ma_get_bytes_per_frame(format, (ma_uint32)speech.channels);
+    ma_uint64 framesWritten = 0;
+    result = ma_encoder_write_pcm_frames(&encoder, speech.pData, frameCount, &framesWritten);
+    ma_encoder_uninit(&encoder);
+    if (result != MA_SUCCESS || framesWritten != frameCount) {
+        spdlog::error("Failed to write {}: {}", path.string(), ma_result_description(result));
+        return false;
+    }
+    return true;
+}
+
+int RunBatchRender(const CliOptions& options) {
+    const std::filesystem::path outputDir = options.batchOutputDir;
+    auto phrases = readPhraseList(options.batchFile, outputDir);
+    if (!phrases.has_value()) {
+        spdlog::error("Failed to read the phrase list {}", options.batchFile);
+        return 1;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(outputDir, error);
+    if (error) {
+        spdlog::error("Failed to create the output directory {}: {}", outputDir.string(), error.message());
+        return 1;
+    }
+
+    size_t workerCount = options.batchJobs != 0 ? options.batchJobs : std::thread::hardware_concurrency();
+    workerCount = std::clamp<size_t>(workerCount, 1, std::max<size_t>(phrases->size(), 1));
+    spdlog::debug("Rendering {} phrases with {} workers", phrases->size(), workerCount);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextPhrase = 0;
+    std::atomic<size_t> renderedCount = 0;
+    std::atomic<uint64_t> renderedMilliseconds = 0;
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back([&] {
+                // Engines keep per-voice state, so every worker owns one
+                auto engine = CreateSpeechEngine(options);
+                const auto voices = engine->getVoices();
+                std::vector<std::string> voiceNames;
+                for (const auto& voice : voices) {
+                    voiceNames.push_back(voice.name);
+                }
+                if (voiceNames.empty()) {
+                    spdlog::error("No voices available");
+                    return;
+                }
+                const size_t voiceIndex = ResolveVoiceIndex(voiceNames, options.voiceName, options.voiceIndex);
+                if (!voices[voiceIndex].isSupported || !engine->setVoice(voiceIndex)) {
+                    spdlog::error("Voice {} cannot render into memory", voiceNames[voiceIndex]);
+                    return;
+                }
+                for (size_t index = nextPhrase++; index < phrases->size(); index = nextPhrase++) {
+                    const BatchPhrase& phrase = (*phrases)[index];
+                    auto speech = engine->synthesize(phrase.text.c_str());
+                    if (!speech.has_value()) {
+                        spdlog::error("Failed to render: {}", phrase.text);
+                        continue;
+                    }
+                    if (writeWavFile(phrase.outputPath, *speech)) {
+                        renderedCount++;
+                        const uint64_t frameCount =
+                            speech->bufferSize / ((uint64_t)speech->channels * (speech->bitsPerSample / 8));
+                        renderedMilliseconds += frameCount * 1000 / (uint64_t)speech->sampleRate;
+                    }
+                    free(speech->pData);
+                }
+            });
+        }
+    }
+    const std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+
+    const double audioSeconds = renderedMilliseconds / 1000.0;
+    std::puts(std::format("Rendered {} of {} phrases with {} workers in {:.2f} s: {:.1f} phrases/s, {:.1f} s of audio "
+                          "({:.1f}x real time)",
+                          renderedCount.load(), phrases->size(), workerCount, wallTime.count(),
+                          renderedCount / wallTime.count(), audioSeconds, audioSeconds / wallTime.count())
+                  .c_str());
+    return renderedCount == phrases->size() ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "cliOptions.h"
+
+// Renders every phrase of the batch list to its own WAV file on a pool of workers, returns the exit code.
+// Non-zero means the list could not be read or at least one phrase was not rendered
+int RunBatchRender(const CliOptions& options);
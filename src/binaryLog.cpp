@@ -0,0 +1,133 @@
+#include "binaryLog.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <type_traits>
+
+// Larger than the default, messages arrive in batches and are flushed once per batch
+static constexpr size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+static FILE* openFile(const std::filesystem::path& path, const char* mode) {
+#ifdef _WIN32
+    std::wstring wideMode(mode, mode + std::strlen(mode));
+    return _wfopen(path.c_str(), wideMode.c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+template <class T> static std::span<const std::byte> asBytes(const T& value) {
+    return std::as_bytes(std::span(&value, 1));
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    close();
+}
+
+bool BinaryLogWriter::open(const std::filesystem::path& path) {
+    close();
+    m_pFile = openFile(path, "wb");
+    if (m_pFile == nullptr) {
+        spdlog::error("Failed to create the binary log {}", path.string());
+        return false;
+    }
+    setvbuf(m_pFile, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+    if (fwrite(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC), 1, m_pFile) != 1) {
+        spdlog::error("Failed to write the binary log {}", path.string());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BinaryLogWriter::close() {
+    if (m_pFile != nullptr) {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+    m_formatIds.clear();
+    m_stringIds.clear();
+}
+
+void BinaryLogWriter::writeMessage(int64_t timeNs, uint64_t threadId, int level, const char* format,
+                                   std::span<const RtLogArg> args) {
+    if (m_pFile == nullptr) {
+        return;
+    }
+    std::array<BinaryLogArg, RT_LOG_MAX_ARGS> binaryArgs{};
+    const size_t argCount = std::min(args.size(), binaryArgs.size());
+    for (size_t i = 0; i < argCount; ++i) {
+        BinaryLogArg& binaryArg = binaryArgs[i];
+        binaryArg.type = static_cast<uint32_t>(args[i].index());
+        std::visit(
+            [&](auto value) {
+                using T = decltype(value);
+                if constexpr (std::is_same_v<T, const char*>) {
+                    binaryArg.value = define(m_stringIds, BinaryLogRecordType::StringDefinition,
+                                             value != nullptr ? value : "(null)");
+                } else if constexpr (std::is_same_v<T, double>) {
+                    binaryArg.value = std::bit_cast<uint64_t>(value);
+                } else {
+                    binaryArg.value = static_cast<uint64_t>(value);
+                }
+            },
+            args[i]);
+    }
+    BinaryLogMessage message{timeNs,
+                             threadId,
+                             define(m_formatIds, BinaryLogRecordType::FormatDefinition, format),
+                             static_cast<uint8_t>(level),
+                             static_cast<uint8_t>(argCount),
+                             0};
+    const std::array<std::span<const std::byte>, 2> bodyParts{
+        asBytes(message), std::as_bytes(std::span(binaryArgs.data(), argCount))};
+    writeRecord(BinaryLogRecordType::Message, bodyParts);
+}
+
+void BinaryLogWriter::writeDropped(int64_t timeNs, uint64_t threadId, uint64_t count) {
+    if (m_pFile == nullptr) {
+        return;
+    }
+    BinaryLogDropped dropped{timeNs, threadId, count};
+    const std::array<std::span<const std::byte>, 1> bodyParts{asBytes(dropped)};
+    writeRecord(BinaryLogRecordType::Dropped, bodyParts);
+}
+
+void BinaryLogWriter::flush() {
+    if (m_pFile != nullptr) {
+        fflush(m_pFile);
+    }
+}
+
+uint32_t BinaryLogWriter::define(std::unordered_map<const char*, uint32_t>& ids, BinaryLogRecordType type,
+                                 const char* text) {
+    auto [it, isInserted] = ids.try_emplace(text, static_cast<uint32_t>(ids.size()));
+    if (isInserted) {
+        BinaryLogDefinition definition{it->second, 0};
+        const std::string_view string = text;
+        const std::array<std::span<const std::byte>, 2> bodyParts{asBytes(definition),
+                                                                  std::as_bytes(std::span(string))};
+        writeRecord(type, bodyParts);
+    }
+    return it->second;
+}
+
+void BinaryLogWriter::writeRecord(BinaryLogRecordType type, std::span<const std::span<const std::byte>> bodyParts) {
+    BinaryLogRecordHeader header{static_cast<uint32_t>(type), 0};
+    for (const auto& part : bodyParts) {
+        header.bodySize += static_cast<uint32_t>(part.size());
+    }
+    bool isWritten = fwrite(&header, sizeof(header), 1, m_pFile) == 1;
+    for (const auto& part : bodyParts) {
+        isWritten = isWritten && (part.empty() || fwrite(part.data(), part.size(), 1, m_pFile) == 1);
+    }
+    if (!isWritten) {
+        spdlog::error("Failed to write the binary log, the rest of the real-time messages are lost");
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "rtLogFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <unordered_map>
+
+inline constexpr char BINARY_LOG_MAGIC[8] = {'S', 'I', 'M', 'B', 'L', 'O', 'G', '1'};
+
+enum class BinaryLogRecordType : uint32_t {
+    // BinaryLogDefinition followed by the text, without a terminator
+    FormatDefinition = 1,
+    StringDefinition = 2,
+    // BinaryLogMessage followed by argCount BinaryLogArg
+    Message = 3,
+    // BinaryLogDropped
+    Dropped = 4,
+};
+
+// Starts every record, the decoder skips the bodies of record types it does not know
+struct BinaryLogRecordHeader {
+    uint32_t type;
+    uint32_t bodySize;
+};
+
+struct BinaryLogDefinition {
+    uint32_t id;
+    uint32_t reserved;
+};
+
+struct BinaryLogMessage {
+    // Since the epoch of spdlog::log_clock
+    int64_t timeNs;
+    uint64_t threadId;
+    uint32_t formatId;
+    uint8_t level;
+    uint8_t argCount;
+    uint16_t reserved;
+};
+
+// Same order as the alternatives of RtLogArg
+enum class BinaryLogArgType : uint32_t {
+    Int64 = 0,
+    UInt64 = 1,
+    Double = 2,
+    Bool = 3,
+    // The value is the ID of a string definition
+    String = 4,
+};
+
+struct BinaryLogArg {
+    uint32_t type;
+    uint32_t reserved;
+    // The bits of the value, a double is copied as is
+    uint64_t value;
+};
+
+struct BinaryLogDropped {
+    int64_t timeNs;
+    // The drain thread which noticed the loss
+    uint64_t threadId;
+    uint64_t count;
+};
+
+static_assert(sizeof(BinaryLogRecordHeader) == 8);
+static_assert(sizeof(BinaryLogDefinition) == 8);
+static_assert(sizeof(BinaryLogMessage) == 24);
+static_assert(sizeof(BinaryLogArg) == 16);
+static_assert(sizeof(BinaryLogDropped) == 24);
+static_assert(std::variant_size_v<RtLogArg> == 5);
+
+/*
+Writes the messages of the real-time logger without formatting them, for sim_logdecode to turn into text later.
+Format strings and string arguments are literals, so each one is written once as a definition the first time its
+address is seen, and messages refer to them by ID. Records are written in the byte order of the machine.
+Not thread-safe, only the drain thread of the real-time logger uses it.
+*/
+class BinaryLogWriter {
+  public:
+    BinaryLogWriter() = default;
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool isOpen() const { return m_pFile != nullptr; }
+
+    void writeMessage(int64_t timeNs, uint64_t threadId, int level, const char* format,
+                      std::span<const RtLogArg> args);
+    void writeDropped(int64_t timeNs, uint64_t threadId, uint64_t count);
+    void flush();
+
+  private:
+    FILE* m_pFile = nullptr;
+    std::unordered_map<const char*, uint32_t> m_formatIds;
+    std::unordered_map<const char*, uint32_t> m_stringIds;
+
+    uint32_t define(std::unordered_map<const char*, uint32_t>& ids, BinaryLogRecordType type, const char* text);
+    void writeRecord(BinaryLogRecordType type, std::span<const std::span<const std::byte>> bodyParts);
+};
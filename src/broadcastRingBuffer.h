@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+/*
+Fixed-size lock-free ring buffer for one producer thread and up to MaxReaders consumer threads. Every reader gets
+every element at its own pace from its own position, and the producer only overwrites what the slowest active reader
+has read. Neither side ever allocates or blocks, so readers are safe to use from audio device callbacks.
+Readers must be added and removed while the producer is not writing and the affected reader is not reading.
+The capacity is rounded up to a power of two.
+*/
+template <class T, size_t MaxReaders> class BroadcastRingBuffer {
+  public:
+    explicit BroadcastRingBuffer(size_t capacity)
+        : m_capacity(std::bit_ceil(capacity)), m_mask(m_capacity - 1), m_data(std::make_unique<T[]>(m_capacity)) {}
+
+    BroadcastRingBuffer(const BroadcastRingBuffer&) = delete;
+    BroadcastRingBuffer& operator=(const BroadcastRingBuffer&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Producer side. Without readers nothing can be written, so audio is kept until a device reads it
+    size_t availableToWrite() const {
+        const auto largestBacklog = getLargestBacklog();
+        return largestBacklog.has_value() ? m_capacity - *largestBacklog : 0;
+    }
+
+    size_t write(const T* pData, size_t count) {
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        count = std::min(count, availableToWrite());
+        const size_t offset = writeIndex & m_mask;
+        const size_t firstPart = std::min(count, m_capacity - offset);
+        std::copy_n(pData, firstPart, &m_data[offset]);
+        std::copy_n(pData + firstPart, count - firstPart, &m_data[0]);
+        m_writeIndex.store(writeIndex + count, std::memory_order_release);
+        return count;
+    }
+
+    // Starts at the slowest active reader, or where the last reader stopped when there is none. No value when all
+    // readers are in use
+    std::optional<size_t> addReader() {
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        auto backlog = getLargestBacklog();
+        if (!backlog.has_value()) {
+            // Indices only grow, so the reader closest to the writer is the one which stopped last
+            backlog = writeIndex - m_readers[0].readIndex.load(std::memory_order_relaxed);
+            for (const Reader& reader : m_readers) {
+                backlog = std::min(*backlog, writeIndex - reader.readIndex.load(std::memory_order_relaxed));
+            }
+        }
+        for (size_t i = 0; i < MaxReaders; ++i) {
+            if (!m_readers[i].isActive.load(std::memory_order_relaxed)) {
+                m_readers[i].readIndex.store(writeIndex - *backlog, std::memory_order_relaxed);
+                m_readers[i].isActive.store(true, std::memory_order_release);
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void removeReader(size_t reader) { m_readers[reader].isActive.store(false, std::memory_order_release); }
+
+    // Consumer side. The backlog of any reader may be checked from any thread
+    size_t availableToRead(size_t reader) const {
+        // Loaded before the write index, which is never behind it
+        const size_t readIndex = m_readers[reader].readIndex.load(std::memory_order_acquire);
+        return m_writeIndex.load(std::memory_order_acquire) - readIndex;
+    }
+
+    // Positions in the stream, they only grow and wrap around at the end of size_t
+    size_t getWriteIndex() const { return m_writeIndex.load(std::memory_order_acquire); }
+    size_t getReadIndex(size_t reader) const { return m_readers[reader].readIndex.load(std::memory_order_acquire); }
+
+    // Largest backlog of the active readers, zero once all of them have read everything
+    size_t maxAvailableToRead() const { return getLargestBacklog().value_or(0); }
+
+    size_t read(size_t reader, T* pData, size_t count) {
+        std::atomic<size_t>& readIndexRef = m_readers[reader].readIndex;
+        const size_t readIndex = readIndexRef.load(std::memory_order_relaxed);
+        count = std::min(count, m_writeIndex.load(std::memory_order_acquire) - readIndex);
+        const size_t offset = readIndex & m_mask;
+        const size_t firstPart = std::min(count, m_capacity - offset);
+        std::copy_n(&m_data[offset], firstPart, pData);
+        std::copy_n(&m_data[0], count - firstPart, pData + firstPart);
+        readIndexRef.store(readIndex + count, std::memory_order_release);
+        return count;
+    }
+
+    // Moves past elements without copying them
+    size_t skip(size_t reader, size_t count) {
+        std::atomic<size_t>& readIndexRef = m_readers[reader].readIndex;
+        const size_t readIndex = readIndexRef.load(std::memory_order_relaxed);
+        count = std::min(count, m_writeIndex.load(std::memory_order_acquire) - readIndex);
+        readIndexRef.store(readIndex + count, std::memory_order_release);
+        return count;
+    }
+
+  private:
+    struct Reader {
+        alignas(64) std::atomic<size_t> readIndex = 0;
+        std::atomic<bool> isActive = false;
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_data;
+    // Indices grow monotonically and are wrapped with the mask on access
+    alignas(64) std::atomic<size_t> m_writeIndex = 0;
+    std::array<Reader, MaxReaders> m_readers;
+
+    // Elements the slowest active reader has yet to read, no value without active readers
+    std::optional<size_t> getLargestBacklog() const {
+        std::array<size_t, MaxReaders> readIndices;
+        size_t activeCount = 0;
+        for (const Reader& reader : m_readers) {
+            if (reader.isActive.load(std::memory_order_acquire)) {
+                readIndices[activeCount++] = reader.readIndex.load(std::memory_order_acquire);
+            }
+        }
+        if (activeCount == 0) {
+            return std::nullopt;
+        }
+        // Loaded after the read indices, so it is never behind them. Distances to it stay ordered when indices wrap
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+        size_t largestBacklog = 0;
+        for (size_t i = 0; i < activeCount; ++i) {
+            largestBacklog = std::max(largestBacklog, writeIndex - readIndices[i]);
+        }
+        return largestBacklog;
+    }
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+inline constexpr uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+
+// FNV-1a, used both for hashing and for detecting torn records in files
+inline uint64_t Fnv1a64(const void* pData, size_t size, uint64_t hash = FNV1A_64_OFFSET_BASIS) {
+    const auto* pBytes = (const unsigned char*)pData;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ pBytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,203 @@
+#include "cliOptions.h"
+
+#include "historyStorage.h"
+#include "latencyTracker.h"
+#include "loggerSetup.h"
+#include "speech.h"
+#include "speechDiskCache.h"
+#include "sralSpeechEngine.h"
+#include "traceRecorder.h"
+
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+std::optional<int> ParseCliOptions(int argc, char** argv, CliOptions& options) {
+    CLI::App cliApp{"SIM - Speak Instead of Me speech utility"};
+    argv = cliApp.ensure_utf8(argv);
+    cliApp.add_flag("-D,--debug", options.isDebugEnabled, "Enable the debug logging for release builds");
+    cliApp.add_option("--binary-log", options.binaryLogFile,
+                      "Write the frequent debug messages, such as those of every utterance and of the audio devices, "
+                      "to this binary file without formatting them. sim_logdecode turns it back into text");
+    cliApp.add_option(
+        "-n,--voice-name", options.voiceName,
+        "Specify SAPI voice name to be selected at program start. If present and found, then voice index is ignored");
+    cliApp.add_option("-v,--voice", options.voiceIndex,
+                      "Specify SAPI voice index to be selected at program start. If voice is selected by name and is "
+                      "successfully found, then this option is ignored.");
+    cliApp.add_option("-d,--device", options.outputDeviceIndex,
+                      "Specify output device number to be selected at program start");
+    cliApp.add_option("--also-device", options.secondaryOutputDeviceIndices,
+                      "Output device number which plays the speech along with the selected device, e.g. speakers "
+                      "next to a virtual cable for a voice chat. Can be given several times");
+    cliApp.add_flag("-s,--stream", options.isStreamingEnabled,
+                    "Speak long text sentence by sentence, starting playback as soon as the first sentence is ready");
+    const std::map<std::string, PlaybackPolicy> playbackPolicyNames{{"queue", PlaybackPolicy::Queue},
+                                                                    {"interrupt", PlaybackPolicy::Interrupt},
+                                                                    {"drop", PlaybackPolicy::DropIfBusy}};
+    cliApp.add_option("--when-busy", options.playbackPolicy,
+                      "What happens to new speech while the previous one is playing: queue plays it right after, "
+                      "interrupt stops the previous one, drop skips the new one")
+        ->transform(CLI::CheckedTransformer(playbackPolicyNames, CLI::ignore_case));
+    options.cacheSizeMb = SPEECH_CACHE_DEFAULT_BUDGET_BYTES / (1024 * 1024);
+    cliApp.add_option("--cache-size", options.cacheSizeMb,
+                      "Memory in megabytes used to cache rendered phrases, so repeated ones are spoken instantly. "
+                      "0 disables the cache");
+    options.diskCacheSizeMb = SPEECH_DISK_CACHE_DEFAULT_BUDGET_BYTES / (1024 * 1024);
+    cliApp.add_option("--disk-cache-size", options.diskCacheSizeMb,
+                      "Disk space in megabytes used to keep rendered phrases between runs. 0 disables the disk cache");
+    options.historySize = HISTORY_DEFAULT_CAPACITY;
+    cliApp.add_option("--history-size", options.historySize,
+                      "Number of spoken phrases kept for Up and Down arrow navigation, the oldest are forgotten first. "
+                      "0 keeps every phrase");
+    options.historyFile = HISTORY_LOG_DEFAULT_FILE;
+    cliApp.add_option("--history-file", options.historyFile,
+                      "File which keeps the history of spoken phrases between runs. An empty string keeps it in "
+                      "memory only");
+    const std::map<std::string, AudioResampler> resamplerNames{{"linear", AudioResampler::Linear},
+                                                               {"sinc", AudioResampler::Sinc}};
+    cliApp.add_option("--resampler", options.resampler,
+                      "Resampler for voices whose rate differs from the device rate: linear is the cheapest, sinc "
+                      "sounds cleaner with 22 kHz and lower voices")
+        ->transform(CLI::CheckedTransformer(resamplerNames, CLI::ignore_case));
+    cliApp.add_flag("--low-latency", options.deviceConfig.isLowLatency,
+                    "Open the audio device with short periods to hear speech sooner, e.g. in voice chats. The buffer "
+                    "sizes the device got are logged with --debug");
+    cliApp.add_option("--period-size", options.deviceConfig.periodSizeInFrames,
+                      "Frames in each period of the audio device at the device rate, 0 lets the backend choose");
+    cliApp.add_option("--periods", options.deviceConfig.periods,
+                      "Number of periods the audio device buffers, 0 lets the backend choose");
+    cliApp.add_flag("--exclusive", options.deviceConfig.isExclusive,
+                    "Prefer exclusive mode of the audio device, which bypasses the system mixer. Shared mode is used "
+                    "when the device does not allow it");
+    const std::map<std::string, SpeechEngineType> engineNames{{"sapi", SpeechEngineType::Sapi},
+                                                              {"synthetic", SpeechEngineType::Synthetic}};
+    cliApp.add_option("--engine", options.engine,
+                      "Speech engine: sapi speaks with the installed voices, synthetic renders tones or noise for "
+                      "benchmarking the playback without SAPI. Synthetic phrases are not kept in the disk cache")
+        ->transform(CLI::CheckedTransformer(engineNames, CLI::ignore_case));
+    const std::map<std::string, SyntheticWaveform> waveformNames{{"tone", SyntheticWaveform::Tone},
+                                                                 {"noise", SyntheticWaveform::Noise}};
+    cliApp.add_option("--synthetic-waveform", options.syntheticSpeech.waveform, "Signal of the synthetic engine")
+        ->transform(CLI::CheckedTransformer(waveformNames, CLI::ignore_case));
+    cliApp.add_option("--synthetic-sample-rate", options.syntheticSpeech.sampleRate,
+                      "Sample rate of the synthetic engine in Hz")
+        ->check(CLI::Range(8000, 192000));
+    cliApp.add_option("--synthetic-bits", options.syntheticSpeech.bitsPerSample,
+                      "Bits per sample of the synthetic engine")
+        ->check(CLI::IsMember({8, 16, 24, 32}));
+    cliApp.add_option("--synthetic-channels", options.syntheticSpeech.channels,
+                      "Channel count of the synthetic engine")
+        ->check(CLI::Range(1, 8));
+    int renderLatencyMs = 0;
+    cliApp.add_option("--synthetic-latency", renderLatencyMs,
+                      "Milliseconds the synthetic engine spends on every phrase, like a real engine would")
+        ->check(CLI::NonNegativeNumber);
+    cliApp.add_option("--speak", options.speakTexts,
+                      "Speak the text without opening the window and exit when it is played. Can be repeated");
+    cliApp.add_flag("--stdin", options.isStdinEnabled,
+                    "Speak every line of the standard input without opening the window and exit at its end");
+    cliApp.add_option("--batch", options.batchFile,
+                      "Render every line of the file to a WAV file without opening the window and exit. A line is "
+                      "either the text or a file name and the text separated by a tab")
+        ->check(CLI::ExistingFile);
+    cliApp.add_option("--batch-output", options.batchOutputDir, "Directory the batch WAV files are written to");
+    cliApp.add_option("--jobs", options.batchJobs,
+                      "Batch workers rendering in parallel, 0 uses one per CPU core. SAPI voices render one phrase at "
+                      "a time, so with them only writing the files runs in parallel");
+    options.latencyLogIntervalSeconds = static_cast<int>(LATENCY_DEFAULT_LOG_INTERVAL.count());
+    cliApp.add_option("--latency-log-interval", options.latencyLogIntervalSeconds,
+                      "Seconds between reports of p50, p95 and p99 latencies from Enter to each speech stage, logged "
+                      "with --debug. 0 disables them, F9 logs the statistics since startup at any time")
+        ->check(CLI::NonNegativeNumber);
+    cliApp.add_option("--trace", options.traceFile,
+                      "Write the timings of speech and playback to a Chrome trace file on exit, which Perfetto "
+                      "opens with a track per thread. Needs a build configured with SIM_ENABLE_TRACING");
+    options.helpText = cliApp.help();
+
+    try {
+        cliApp.parse(argc, argv);
+    } catch (const CLI::ParseError& error) {
+        AttachParentConsole();
+        return cliApp.exit(error);
+    }
+    options.syntheticSpeech.renderLatency = std::chrono::milliseconds(renderLatencyMs);
+    return std::nullopt;
+}
+
+void ApplyCliOptions(const CliOptions& options, int argc, char** argv) {
+    InitializeLogging(argc, argv, options.isDebugEnabled, options.binaryLogFile);
+    if (!options.traceFile.empty()) {
+#ifdef SIM_ENABLE_TRACING
+        g_TraceRecorder.start(options.traceFile);
+#else
+        spdlog::warn("Tracing is not compiled in, configure with SIM_ENABLE_TRACING to record {}", options.traceFile);
+#endif
+    }
+    g_LatencyTracker.startPeriodicLogging(std::chrono::seconds(options.latencyLogIntervalSeconds));
+    Speech::GetInstance().setEngine(CreateSpeechEngine(options));
+    Speech::GetInstance().setStreamingEnabled(options.isStreamingEnabled);
+    Speech::GetInstance().setPlaybackPolicy(options.playbackPolicy);
+    g_Audio.setResampler(options.resampler);
+    g_Audio.setDeviceConfig(options.deviceConfig);
+    g_Audio.selectSecondaryDevices(options.secondaryOutputDeviceIndices);
+    Speech::GetInstance().setCacheBudget(options.cacheSizeMb * 1024 * 1024);
+    g_HistoryStorage.setCapacity(options.historySize);
+    // The synthetic engine is there to measure the pipeline, so it renders every phrase instead of reading back the
+    // audio of an earlier run, whose --synthetic-* settings the cache keys do not record
+    if (options.engine == SpeechEngineType::Sapi &&
+        !Speech::GetInstance().openDiskCache(options.diskCacheSizeMb * 1024 * 1024)) {
+        spdlog::warn("Speech disk cache is unavailable, phrases are cached in memory only");
+    }
+}
+
+std::unique_ptr<ISpeechEngine> CreateSpeechEngine(const CliOptions& options) {
+    if (options.engine == SpeechEngineType::Synthetic) {
+        return std::make_unique<SyntheticSpeechEngine>(options.syntheticSpeech);
+    }
+    return std::make_unique<SralSpeechEngine>();
+}
+
+size_t ResolveVoiceIndex(const std::vector<std::string>& voices, const std::string& voiceName, int voiceIndex) {
+    if (!voiceName.empty()) {
+        for (size_t i = 0; i < voices.size(); ++i) {
+            if (voices[i] == voiceName) {
+                return i;
+            }
+        }
+    }
+    if (voiceIndex < 0 || static_cast<size_t>(voiceIndex) >= voices.size()) {
+        spdlog::warn("Voice index {} is out of range. Falling back to 0.", voiceIndex);
+        return 0;
+    }
+    return static_cast<size_t>(voiceIndex);
+}
+
+void AttachParentConsole() {
+#ifdef _WIN32
+    // Redirected handles are inherited by GUI programs too and must be kept, only missing ones go to the console
+    const bool hasInput = GetStdHandle(STD_INPUT_HANDLE) != nullptr;
+    const bool hasOutput = GetStdHandle(STD_OUTPUT_HANDLE) != nullptr;
+    const bool hasError = GetStdHandle(STD_ERROR_HANDLE) != nullptr;
+    if (!AttachConsole(ATTACH_PARENT_PROCESS)) {
+        return;
+    }
+    if (!hasInput) {
+        freopen("CONIN$", "r", stdin);
+    }
+    if (!hasOutput) {
+        freopen("CONOUT$", "w", stdout);
+    }
+    if (!hasError) {
+        freopen("CONOUT$", "w", stderr);
+    }
+#endif
+}
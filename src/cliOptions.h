@@ -0,0 +1,69 @@
+#pragma once
+
+#include "audio.h"
+#include "singleton.h"
+#include "speechEngine.h"
+#include "syntheticSpeechEngine.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class SpeechEngineType {
+    Sapi,
+    // Tones or noise instead of speech, for measuring the playback pipeline without SAPI
+    Synthetic,
+};
+
+struct CliOptions {
+    bool isDebugEnabled = false;
+    // Real-time log messages are written here unformatted, for sim_logdecode
+    std::string binaryLogFile;
+    std::string voiceName;
+    int voiceIndex = 0;
+    int outputDeviceIndex = 0;
+    // Devices which play everything along with the selected one
+    std::vector<size_t> secondaryOutputDeviceIndices;
+    bool isStreamingEnabled = false;
+    PlaybackPolicy playbackPolicy = PlaybackPolicy::Queue;
+    size_t cacheSizeMb = 0;
+    size_t diskCacheSizeMb = 0;
+    // Zero keeps every phrase
+    size_t historySize = 0;
+    // Empty keeps the history in memory only
+    std::string historyFile;
+    AudioResampler resampler = AudioResampler::Linear;
+    AudioDeviceConfig deviceConfig;
+    SpeechEngineType engine = SpeechEngineType::Sapi;
+    SyntheticSpeechConfig syntheticSpeech;
+    // Headless mode: speak these texts and lines from the standard input, then exit without creating any window
+    std::vector<std::string> speakTexts;
+    bool isStdinEnabled = false;
+    // Batch mode: render every phrase of the list to a WAV file in the output directory, then exit
+    std::string batchFile;
+    std::string batchOutputDir = ".";
+    // Zero uses a worker per CPU core
+    size_t batchJobs = 0;
+    // Zero disables the periodic latency report
+    int latencyLogIntervalSeconds = 0;
+    // Chrome trace of the timed zones, only recorded by builds configured with SIM_ENABLE_TRACING
+    std::string traceFile;
+    std::string helpText;
+
+    bool isHeadless() const { return !speakTexts.empty() || isStdinEnabled; }
+    bool isBatch() const { return !batchFile.empty(); }
+};
+
+#define g_CliOptions CSingleton<CliOptions>::GetInstance()
+
+// Returns the exit code when the program should exit right away, e.g. after printing help or a parsing error
+std::optional<int> ParseCliOptions(int argc, char** argv, CliOptions& options);
+// Initializes logging and applies the options which do not depend on the UI
+void ApplyCliOptions(const CliOptions& options, int argc, char** argv);
+std::unique_ptr<ISpeechEngine> CreateSpeechEngine(const CliOptions& options);
+// Voice selected by name if it is found, otherwise by index, falling back to the first voice
+size_t ResolveVoiceIndex(const std::vector<std::string>& voices, const std::string& voiceName, int voiceIndex);
+// Lets the GUI subsystem build print to and read from the console it was started from
+void AttachParentConsole();
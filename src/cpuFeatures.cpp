@@ -0,0 +1,66 @@
+#include "cpuFeatures.h"
+
+#include <cstdint>
+
+#ifdef SIM_CPU_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef SIM_CPU_X86
+static void readCpuid(unsigned leaf, unsigned subleaf, unsigned registers[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    __cpuidex((int*)registers, (int)leaf, (int)subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static uint64_t readEnabledOsFeatures() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32_t low = 0;
+    uint32_t high = 0;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (uint64_t)high << 32 | low;
+#endif
+}
+
+static bool isSse2Supported() {
+    unsigned registers[4];
+    readCpuid(1, 0, registers);
+    return (registers[3] & (1u << 26)) != 0;
+}
+
+static bool isAvx2Supported() {
+    unsigned registers[4];
+    readCpuid(0, 0, registers);
+    if (registers[0] < 7) {
+        return false;
+    }
+    readCpuid(1, 0, registers);
+    const bool isOsSavingAvxState = (registers[2] & (1u << 27)) != 0 && (registers[2] & (1u << 28)) != 0 &&
+                                    (readEnabledOsFeatures() & 0x6) == 0x6;
+    if (!isOsSavingAvxState) {
+        return false;
+    }
+    readCpuid(7, 0, registers);
+    return (registers[1] & (1u << 5)) != 0;
+}
+#endif
+
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = [] {
+        CpuFeatures detected;
+#ifdef SIM_CPU_X86
+        detected.hasSse2 = isSse2Supported();
+        detected.hasAvx2 = isAvx2Supported();
+#endif
+        return detected;
+    }();
+    return features;
+}
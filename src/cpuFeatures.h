@@ -0,0 +1,14 @@
+#pragma once
+
+// Set on the architectures which have the SSE2 and AVX2 kernels, the others only get the scalar ones
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIM_CPU_X86
+#endif
+
+// Instruction sets the CPU and the OS support, detected once on the first call
+struct CpuFeatures {
+    bool hasSse2 = false;
+    bool hasAvx2 = false;
+};
+
+const CpuFeatures& GetCpuFeatures();
@@ -0,0 +1,78 @@
+#include "deviceRegistry.h"
+
+#include "audio.h"
+#include "checksum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+size_t DeviceIdHash::operator()(const ma_device_id& id) const {
+    // ma_device_id_equal compares raw bytes, so the hash covers the same bytes
+    return static_cast<size_t>(Fnv1a64(&id, sizeof(id)));
+}
+
+std::vector<DeviceInfo> CDeviceRegistry::getDevices() {
+    std::lock_guard lock(m_mutex);
+    updateIfStale();
+    return m_devices;
+}
+
+std::optional<ma_device_id> CDeviceRegistry::getDeviceId(size_t deviceIndex) {
+    std::lock_guard lock(m_mutex);
+    updateIfStale();
+    if (deviceIndex >= m_devices.size()) {
+        return std::nullopt;
+    }
+    return m_devices[deviceIndex].id;
+}
+
+bool CDeviceRegistry::contains(const ma_device_id& deviceID) {
+    std::lock_guard lock(m_mutex);
+    updateIfStale();
+    return m_indexById.contains(deviceID);
+}
+
+void CDeviceRegistry::refresh() {
+    std::lock_guard lock(m_mutex);
+    enumerate();
+}
+
+void CDeviceRegistry::invalidate() {
+    m_isStale.store(true, std::memory_order_release);
+}
+
+void CDeviceRegistry::updateIfStale() {
+    if (m_isStale.load(std::memory_order_acquire)) {
+        enumerate();
+    }
+}
+
+void CDeviceRegistry::enumerate() {
+    const auto startTime = std::chrono::steady_clock::now();
+    m_isStale.store(false, std::memory_order_release);
+    ma_device_info* pDeviceInfos;
+    ma_uint32 deviceCount;
+    ma_result result = ma_context_get_devices(g_AudioContext, &pDeviceInfos, &deviceCount, nullptr, nullptr);
+    if (result != MA_SUCCESS) {
+        spdlog::critical("Failed to get list of devices");
+        throw std::runtime_error("Failed to get list of devices");
+    }
+
+    m_devices.clear();
+    m_devices.reserve(deviceCount);
+    for (ma_uint32 i = 0; i < deviceCount; ++i) {
+        m_devices.push_back(DeviceInfo(pDeviceInfos[i].id, pDeviceInfos[i].name, pDeviceInfos[i].isDefault == MA_TRUE));
+    }
+    std::stable_sort(m_devices.begin(), m_devices.end(), [](const DeviceInfo& first, const DeviceInfo& second) {
+        return first.isDefault > second.isDefault;
+    });
+
+    m_indexById.clear();
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        m_indexById.emplace(m_devices[i].id, i);
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    spdlog::debug("Enumerated {} playback devices in {:.2f} ms", m_devices.size(), elapsed.count());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <miniaudio.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DeviceInfo {
+    ma_device_id id;
+    std::string name;
+    bool isDefault;
+};
+
+struct DeviceIdHash {
+    size_t operator()(const ma_device_id& id) const;
+};
+
+struct DeviceIdEqual {
+    bool operator()(const ma_device_id& first, const ma_device_id& second) const {
+        return ma_device_id_equal(&first, &second) == MA_TRUE;
+    }
+};
+
+/*
+Keeps the list of playback devices between enumerations.
+The list is enumerated on first use and then only after invalidate() or refresh(),
+so looking a device up on every utterance costs a hash lookup instead of a full enumeration.
+*/
+class CDeviceRegistry {
+  public:
+    // The default device always comes first, the rest keep the backend order
+    std::vector<DeviceInfo> getDevices();
+    std::optional<ma_device_id> getDeviceId(size_t deviceIndex);
+    bool contains(const ma_device_id& deviceID);
+    void refresh();
+    // Safe to call from miniaudio notification callbacks, the list is enumerated again on next access
+    void invalidate();
+
+  private:
+    std::mutex m_mutex;
+    std::vector<DeviceInfo> m_devices;
+    std::unordered_map<ma_device_id, size_t, DeviceIdHash, DeviceIdEqual> m_indexById;
+    std::atomic<bool> m_isStale = true;
+
+    void updateIfStale();
+    void enumerate();
+};
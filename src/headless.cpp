@@ -0,0 +1,64 @@
+#include "headless.h"
+
+#include "audio.h"
+#include "latencyTracker.h"
+#include "speech.h"
+#include "traceRecorder.h"
+
+#include <chrono>
+#include <iostream>
+#include <spdlog/spdlog.h>
+#include <string>
+
+int RunHeadless(const CliOptions& options) {
+    SIM_TRACE_THREAD_NAME("Main");
+    const auto startTime = std::chrono::steady_clock::now();
+    auto& speech = Speech::GetInstance();
+    auto voices = speech.getVoicesList();
+    if (voices.empty()) {
+        spdlog::error("No voices available");
+        return 1;
+    }
+    speech.setVoice(ResolveVoiceIndex(voices, options.voiceName, options.voiceIndex));
+
+    auto devices = g_Audio.getDevicesList();
+    size_t deviceIndex = 0;
+    if (options.outputDeviceIndex >= 0 && static_cast<size_t>(options.outputDeviceIndex) < devices.size()) {
+        deviceIndex = static_cast<size_t>(options.outputDeviceIndex);
+    } else {
+        spdlog::warn("Device index {} is out of range. Falling back to 0.", options.outputDeviceIndex);
+    }
+    g_Audio.selectDevice(deviceIndex);
+    const std::chrono::duration<double, std::milli> startupTime = std::chrono::steady_clock::now() - startTime;
+    spdlog::debug("Headless mode is ready in {:.1f} ms", startupTime.count());
+
+    // Each text is queued right after synthesis, so the next one is synthesized while the previous one plays
+    size_t failedCount = 0;
+    auto speakText = [&](const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        if (!speech.speak(text.c_str())) {
+            spdlog::error("Failed to speak: {}", text);
+            failedCount++;
+        }
+    };
+    for (const auto& text : options.speakTexts) {
+        speakText(text);
+    }
+    if (options.isStdinEnabled) {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            speakText(line);
+        }
+    }
+
+    g_Audio.waitUntilIdle();
+    g_LatencyTracker.logStatistics();
+    const std::chrono::duration<double, std::milli> runTime = std::chrono::steady_clock::now() - startTime;
+    spdlog::debug("Headless run finished in {:.1f} ms, failed texts: {}", runTime.count(), failedCount);
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "cliOptions.h"
+
+// Speaks the texts from the command line and the standard input without wxWidgets, returns the exit code.
+// Non-zero means at least one text could not be spoken
+int RunHeadless(const CliOptions& options);
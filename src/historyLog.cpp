@@ -0,0 +1,283 @@
+#include "historyLog.h"
+
+#include "checksum.h"
+#include "mappedFile.h"
+
+#include <chrono>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+static constexpr char HISTORY_LOG_MAGIC[8] = {'S', 'I', 'M', 'H', 'S', 'T', 'L', '1'};
+static constexpr uint32_t RECORD_TYPE_PUSH = 1;
+static constexpr uint32_t MAX_TEXT_SIZE = 1024 * 1024;
+
+// Followed by textSize bytes of the phrase
+struct HistoryLogRecord {
+    uint32_t type;
+    uint32_t textSize;
+    // FNV-1a of the record with this field zeroed, followed by the text
+    uint64_t checksum;
+};
+
+static_assert(sizeof(HistoryLogRecord) == 16);
+
+static FILE* openFile(const std::filesystem::path& path, const char* mode) {
+#ifdef _WIN32
+    std::wstring wideMode(mode, mode + std::strlen(mode));
+    return _wfopen(path.c_str(), wideMode.c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+static uint64_t computeRecordChecksum(HistoryLogRecord record, std::string_view text) {
+    record.checksum = 0;
+    return Fnv1a64(text.data(), text.size(), Fnv1a64(&record, sizeof(record)));
+}
+
+// Collects the valid records from the start of the mapped file and returns where they end
+static size_t readRecords(const uint8_t* pData, size_t fileSize, std::vector<std::string_view>& records) {
+    size_t offset = sizeof(HISTORY_LOG_MAGIC);
+    while (fileSize - offset >= sizeof(HistoryLogRecord)) {
+        HistoryLogRecord record;
+        std::memcpy(&record, pData + offset, sizeof(record));
+        if (record.type != RECORD_TYPE_PUSH || record.textSize == 0 || record.textSize > MAX_TEXT_SIZE ||
+            fileSize - offset - sizeof(record) < record.textSize) {
+            break;
+        }
+        const std::string_view text((const char*)pData + offset + sizeof(record), record.textSize);
+        if (computeRecordChecksum(record, text) != record.checksum) {
+            break;
+        }
+        records.push_back(text);
+        offset += sizeof(record) + record.textSize;
+    }
+    return offset;
+}
+
+HistoryLog::~HistoryLog() {
+    close();
+}
+
+bool HistoryLog::open(const std::filesystem::path& path, const RecordVisitor& visitRecord) {
+    close();
+    m_path = path;
+
+    auto startTime = std::chrono::steady_clock::now();
+    bool isRepairFailed = false;
+    if (!load(visitRecord, isRepairFailed)) {
+        if (isRepairFailed) {
+            // Records appended after the damaged ones would never be loaded
+            spdlog::error("Failed to drop the damaged records of the history log");
+            return false;
+        }
+        spdlog::info("Creating a new history log at {}", m_path.string());
+        m_recordCount = 0;
+        if (!create()) {
+            spdlog::error("Failed to create the history log");
+            return false;
+        }
+    }
+    m_pFile = openFile(m_path, "ab");
+    if (m_pFile == nullptr) {
+        spdlog::error("Failed to open the history log for writing");
+        return false;
+    }
+    m_writer = std::jthread([this](std::stop_token stopToken) { writeTasks(stopToken); });
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    spdlog::info("History log opened in {} ms, records: {}", duration.count(), m_recordCount);
+    return true;
+}
+
+void HistoryLog::close() {
+    if (m_writer.joinable()) {
+        // The writer finishes the queued tasks before it stops
+        m_writer.request_stop();
+        m_writer.join();
+    }
+    if (m_pFile != nullptr) {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+    m_recordCount = 0;
+}
+
+void HistoryLog::append(const std::string& text) {
+    if (!m_writer.joinable() || text.empty() || text.size() > MAX_TEXT_SIZE) {
+        return;
+    }
+    {
+        std::lock_guard lock(m_tasksMutex);
+        m_tasks.push_back(Task{text, 0, false});
+    }
+    m_tasksCondition.notify_one();
+    ++m_recordCount;
+}
+
+void HistoryLog::compact(size_t liveCount, size_t capacity) {
+    if (!m_writer.joinable()) {
+        return;
+    }
+    m_recordCount = liveCount;
+    {
+        std::lock_guard lock(m_tasksMutex);
+        m_tasks.push_back(Task{{}, capacity, true});
+    }
+    m_tasksCondition.notify_one();
+}
+
+bool HistoryLog::load(const RecordVisitor& visitRecord, bool& isRepairFailed) {
+    // Missing and empty files are both started from scratch
+    auto mapping = MappedFile::open(m_path);
+    if (mapping == nullptr) {
+        return false;
+    }
+    const uint8_t* pData = mapping->data();
+    const size_t fileSize = mapping->size();
+    if (fileSize < sizeof(HISTORY_LOG_MAGIC) || std::memcmp(pData, HISTORY_LOG_MAGIC, sizeof(HISTORY_LOG_MAGIC)) != 0) {
+        spdlog::warn("History log is damaged, discarding it");
+        return false;
+    }
+
+    // Records are validated from the start, their sizes only allow walking forward
+    std::vector<std::string_view> records;
+    const size_t offset = readRecords(pData, fileSize, records);
+
+    for (auto iter = records.rbegin(); iter != records.rend(); ++iter) {
+        if (!visitRecord(*iter)) {
+            break;
+        }
+    }
+    m_recordCount = records.size();
+    // The file cannot be truncated or replaced by compaction while it is mapped on Windows
+    mapping.reset();
+
+    // A record torn by a crash is dropped, so new records are not appended after garbage
+    if (offset != fileSize) {
+        spdlog::warn("Dropping {} bytes of damaged records from the history log", fileSize - offset);
+        std::error_code error;
+        std::filesystem::resize_file(m_path, offset, error);
+        if (error) {
+            isRepairFailed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HistoryLog::create() {
+    FILE* pFile = openFile(m_path, "wb");
+    if (pFile == nullptr) {
+        return false;
+    }
+    const bool isSuccessful = fwrite(HISTORY_LOG_MAGIC, sizeof(HISTORY_LOG_MAGIC), 1, pFile) == 1 && SyncFile(pFile);
+    fclose(pFile);
+    return isSuccessful;
+}
+
+void HistoryLog::writeTasks(std::stop_token stopToken) {
+    std::deque<Task> tasks;
+    while (true) {
+        {
+            std::unique_lock lock(m_tasksMutex);
+            m_tasksCondition.wait(lock, stopToken, [this] { return !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return;
+            }
+            tasks.swap(m_tasks);
+        }
+        bool isWritten = false;
+        for (Task& task : tasks) {
+            if (task.isCompaction) {
+                rewrite(task.capacity);
+            } else if (m_pFile != nullptr) {
+                if (!writeRecord(m_pFile, task.text)) {
+                    spdlog::error("Failed to write to the history log, new phrases are not saved anymore");
+                    fclose(m_pFile);
+                    m_pFile = nullptr;
+                }
+                isWritten = true;
+            }
+        }
+        tasks.clear();
+        // Synced once per batch, phrases come in much slower than the disk takes them
+        if (isWritten && m_pFile != nullptr && !SyncFile(m_pFile)) {
+            spdlog::error("Failed to sync the history log");
+        }
+    }
+}
+
+bool HistoryLog::rewrite(size_t capacity) {
+    if (m_pFile == nullptr) {
+        return false;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    // The live phrases are the latest record of each phrase, up to the capacity from the newest, as on load. They
+    // are read from the log itself, so the caller does not have to copy them
+    if (fflush(m_pFile) != 0) {
+        spdlog::error("Failed to compact the history log");
+        return false;
+    }
+    auto mapping = MappedFile::open(m_path);
+    if (mapping == nullptr) {
+        spdlog::error("Failed to compact the history log");
+        return false;
+    }
+    std::vector<std::string_view> records;
+    readRecords(mapping->data(), mapping->size(), records);
+    std::vector<std::string_view> lines;
+    std::unordered_set<std::string_view> seenLines;
+    for (auto iter = records.rbegin(); iter != records.rend() && (capacity == 0 || lines.size() < capacity); ++iter) {
+        if (seenLines.insert(*iter).second) {
+            lines.push_back(*iter);
+        }
+    }
+
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp";
+    FILE* pTempFile = openFile(tempPath, "wb");
+    bool isSuccessful =
+        pTempFile != nullptr && fwrite(HISTORY_LOG_MAGIC, sizeof(HISTORY_LOG_MAGIC), 1, pTempFile) == 1;
+    // From the oldest to the newest
+    for (auto iter = lines.rbegin(); iter != lines.rend() && isSuccessful; ++iter) {
+        isSuccessful = writeRecord(pTempFile, *iter);
+    }
+    isSuccessful = isSuccessful && SyncFile(pTempFile);
+    if (pTempFile != nullptr) {
+        fclose(pTempFile);
+    }
+    const size_t lineCount = lines.size();
+    // The old file cannot be replaced while it is mapped or open on Windows
+    mapping.reset();
+
+    std::error_code error;
+    if (isSuccessful) {
+        fclose(m_pFile);
+        std::filesystem::rename(tempPath, m_path, error);
+        isSuccessful = !error;
+        m_pFile = openFile(m_path, "ab");
+    }
+    if (!isSuccessful) {
+        std::filesystem::remove(tempPath, error);
+        spdlog::error("Failed to compact the history log");
+    }
+    if (m_pFile == nullptr) {
+        spdlog::error("Failed to reopen the history log, new phrases are not saved anymore");
+        return false;
+    }
+    if (isSuccessful) {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+        spdlog::debug("History log compacted to {} phrases in {:.1f} ms", lineCount, elapsed.count());
+    }
+    return isSuccessful;
+}
+
+bool HistoryLog::writeRecord(FILE* pFile, std::string_view text) {
+    HistoryLogRecord record = {};
+    record.type = RECORD_TYPE_PUSH;
+    record.textSize = static_cast<uint32_t>(text.size());
+    record.checksum = computeRecordChecksum(record, text);
+    return fwrite(&record, sizeof(record), 1, pFile) == 1 && fwrite(text.data(), 1, text.size(), pFile) == text.size();
+}
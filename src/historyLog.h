@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+inline constexpr const char* HISTORY_LOG_DEFAULT_FILE = "history.log";
+
+/*
+Append-only file of spoken phrases. A phrase spoken again is appended once more and its latest record wins.
+On load the file is memory-mapped and its records are passed from the newest one in place, so the caller copies only
+the phrases it keeps and may stop early.
+Every record carries a checksum and a torn tail is dropped on load.
+
+Appends and compaction run on a background thread in the order they were requested, so the caller never waits for
+the disk. Compaction rewrites the file with the latest record of each phrase and replaces the old one.
+*/
+class HistoryLog {
+  public:
+    HistoryLog() = default;
+    ~HistoryLog();
+
+    HistoryLog(const HistoryLog&) = delete;
+    HistoryLog& operator=(const HistoryLog&) = delete;
+
+    // Passes the saved records from the newest to the oldest until the visitor returns false. The text points into
+    // the mapping, which is released when open returns
+    using RecordVisitor = std::function<bool(std::string_view text)>;
+    bool open(const std::filesystem::path& path, const RecordVisitor& visitRecord);
+    // Waits until everything requested so far is written
+    void close();
+    void append(const std::string& text);
+    // Rewrites the file with only the latest record of each phrase, the newest capacity of them unless it is zero.
+    // The caller passes the number of phrases that leaves, so the record count is right before the writer gets to it
+    void compact(size_t liveCount, size_t capacity);
+    // Records in the file once the requested writes are done, including superseded ones
+    size_t getRecordCount() const { return m_recordCount; }
+
+  private:
+    struct Task {
+        std::string text;
+        size_t capacity = 0;
+        bool isCompaction = false;
+    };
+
+    std::filesystem::path m_path;
+    // Only used by the writer thread
+    FILE* m_pFile = nullptr;
+    size_t m_recordCount = 0;
+    std::mutex m_tasksMutex;
+    std::condition_variable_any m_tasksCondition;
+    std::deque<Task> m_tasks;
+    std::jthread m_writer;
+
+    // False when the file is missing or damaged and has to be created again
+    bool load(const RecordVisitor& visitRecord, bool& isRepairFailed);
+    bool create();
+    void writeTasks(std::stop_token stopToken);
+    bool rewrite(size_t capacity);
+    static bool writeRecord(FILE* pFile, std::string_view text);
+};
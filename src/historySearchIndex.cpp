@@ -0,0 +1,283 @@
+#include "historySearchIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+// Stale postings tolerated beyond the live ones, so small histories are not rebuilt on every push
+static constexpr size_t REBUILD_SLACK_POSTINGS = 4096;
+static constexpr size_t MAX_QUERY_TRIGRAMS = 64;
+
+static char toLowerAscii(char character) {
+    return character >= 'A' && character <= 'Z' ? static_cast<char>(character - 'A' + 'a') : character;
+}
+
+static size_t hashTrigram(uint32_t trigram) {
+    return (trigram * 2654435761u) >> (32 - std::bit_width(HISTORY_SEARCH_TRIGRAM_FILTER_BITS - 1));
+}
+
+static uint32_t packTrigram(char first, char second, char third) {
+    return (uint32_t)(uint8_t)first << 16 | (uint32_t)(uint8_t)second << 8 | (uint8_t)third;
+}
+
+uint32_t HistorySearchIndex::add(std::string_view text) {
+    if (m_nextSequence == std::numeric_limits<uint32_t>::max()) {
+        rebuild();
+    }
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = static_cast<uint32_t>(m_phrases.size());
+        m_phrases.emplace_back();
+    }
+    m_phrases[id].text = text;
+    m_phrases[id].sequence = m_nextSequence++;
+    addPostings(id);
+    return id;
+}
+
+void HistorySearchIndex::touch(uint32_t id) {
+    if (m_nextSequence == std::numeric_limits<uint32_t>::max()) {
+        rebuild();
+    }
+    retirePostings(id);
+    m_phrases[id].sequence = m_nextSequence++;
+    addPostings(id);
+    rebuildIfStale();
+}
+
+void HistorySearchIndex::remove(uint32_t id) {
+    retirePostings(id);
+    m_phrases[id] = Phrase();
+    m_freeIds.push_back(id);
+    rebuildIfStale();
+}
+
+void HistorySearchIndex::clear() {
+    m_trie.assign(1, TrieNode());
+    m_trigrams.clear();
+    m_phrases.clear();
+    m_freeIds.clear();
+    m_nextSequence = 1;
+    m_livePostingCount = 0;
+    m_stalePostingCount = 0;
+}
+
+std::vector<std::string_view> HistorySearchIndex::search(std::string_view query, size_t maxResults) {
+    std::string lowerQuery(query);
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), toLowerAscii);
+    if (lowerQuery.empty() || maxResults == 0) {
+        return {};
+    }
+    if (++m_queryMark == 0) {
+        for (Phrase& phrase : m_phrases) {
+            phrase.queryMark = 0;
+        }
+        m_queryMark = 1;
+    }
+
+    std::vector<uint32_t> ids;
+    searchPrefix(lowerQuery, maxResults, ids);
+    if (ids.size() < maxResults) {
+        searchFuzzy(lowerQuery, maxResults, ids);
+    }
+    std::vector<std::string_view> results;
+    results.reserve(ids.size());
+    for (uint32_t id : ids) {
+        results.push_back(m_phrases[id].text);
+    }
+    return results;
+}
+
+void HistorySearchIndex::addPostings(uint32_t id) {
+    Phrase& phrase = m_phrases[id];
+    const Posting posting{id, phrase.sequence};
+    uint32_t nodeIndex = 0;
+    const size_t depth = std::min(phrase.text.size(), HISTORY_SEARCH_TRIE_DEPTH);
+    for (size_t i = 0; i < depth; ++i) {
+        const char character = toLowerAscii(phrase.text[i]);
+        auto& children = m_trie[nodeIndex].children;
+        auto iter = std::find_if(children.begin(), children.end(),
+                                 [character](const auto& child) { return child.first == character; });
+        if (iter != children.end()) {
+            nodeIndex = iter->second;
+        } else {
+            // Indices rather than references, adding a node may move the others
+            const auto childIndex = static_cast<uint32_t>(m_trie.size());
+            children.emplace_back(character, childIndex);
+            m_trie.emplace_back();
+            nodeIndex = childIndex;
+        }
+        m_trie[nodeIndex].postings.push_back(posting);
+    }
+
+    collectTrigrams(phrase.text, m_trigramBuffer);
+    for (uint32_t trigram : m_trigramBuffer) {
+        m_trigrams[trigram].push_back(posting);
+    }
+    phrase.postingCount = static_cast<uint32_t>(depth + m_trigramBuffer.size());
+    m_livePostingCount += phrase.postingCount;
+}
+
+void HistorySearchIndex::retirePostings(uint32_t id) {
+    m_livePostingCount -= m_phrases[id].postingCount;
+    m_stalePostingCount += m_phrases[id].postingCount;
+    m_phrases[id].postingCount = 0;
+}
+
+void HistorySearchIndex::rebuildIfStale() {
+    if (m_stalePostingCount > m_livePostingCount + REBUILD_SLACK_POSTINGS) {
+        rebuild();
+    }
+}
+
+void HistorySearchIndex::rebuild() {
+    std::vector<uint32_t> liveIds;
+    liveIds.reserve(m_phrases.size() - m_freeIds.size());
+    for (uint32_t id = 0; id < m_phrases.size(); ++id) {
+        if (m_phrases[id].sequence != 0) {
+            liveIds.push_back(id);
+        }
+    }
+    // Added again from the oldest, so the posting lists stay in recency order
+    std::sort(liveIds.begin(), liveIds.end(), [this](uint32_t first, uint32_t second) {
+        return m_phrases[first].sequence < m_phrases[second].sequence;
+    });
+    m_trie.assign(1, TrieNode());
+    m_trigrams.clear();
+    m_nextSequence = 1;
+    m_livePostingCount = 0;
+    m_stalePostingCount = 0;
+    for (uint32_t id : liveIds) {
+        m_phrases[id].sequence = m_nextSequence++;
+        addPostings(id);
+    }
+}
+
+void HistorySearchIndex::searchPrefix(std::string_view query, size_t maxResults, std::vector<uint32_t>& results) {
+    uint32_t nodeIndex = 0;
+    const size_t depth = std::min(query.size(), HISTORY_SEARCH_TRIE_DEPTH);
+    for (size_t i = 0; i < depth; ++i) {
+        const auto& children = m_trie[nodeIndex].children;
+        auto iter = std::find_if(children.begin(), children.end(),
+                                 [character = query[i]](const auto& child) { return child.first == character; });
+        if (iter == children.end()) {
+            return;
+        }
+        nodeIndex = iter->second;
+    }
+
+    const auto& postings = m_trie[nodeIndex].postings;
+    for (auto iter = postings.rbegin(); iter != postings.rend() && results.size() < maxResults; ++iter) {
+        if (!isLive(*iter)) {
+            continue;
+        }
+        Phrase& phrase = m_phrases[iter->id];
+        // The trie only tells that the first characters match
+        if (query.size() > depth && (phrase.text.size() < query.size() ||
+                                     !std::equal(query.begin() + depth, query.end(), phrase.text.begin() + depth,
+                                                 [](char queryCharacter, char character) {
+                                                     return queryCharacter == toLowerAscii(character);
+                                                 }))) {
+            continue;
+        }
+        phrase.queryMark = m_queryMark;
+        results.push_back(iter->id);
+    }
+}
+
+void HistorySearchIndex::searchFuzzy(std::string_view query, size_t maxResults, std::vector<uint32_t>& results) {
+    std::vector<uint32_t> queryTrigrams;
+    collectTrigrams(query, queryTrigrams);
+    if (queryTrigrams.empty()) {
+        return;
+    }
+    // Shared trigrams are counted in a bit mask
+    if (queryTrigrams.size() > MAX_QUERY_TRIGRAMS) {
+        queryTrigrams.resize(MAX_QUERY_TRIGRAMS);
+    }
+    const size_t neededCount = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil(queryTrigrams.size() * HISTORY_SEARCH_MIN_SHARED_TRIGRAMS)));
+
+    std::vector<const std::vector<Posting>*> postingLists;
+    for (uint32_t trigram : queryTrigrams) {
+        auto iter = m_trigrams.find(trigram);
+        if (iter != m_trigrams.end()) {
+            postingLists.push_back(&iter->second);
+        }
+    }
+    // A match is in neededCount of the lists, so it is in one of the lists left without the neededCount - 1 longest
+    if (postingLists.size() < neededCount) {
+        return;
+    }
+    std::sort(postingLists.begin(), postingLists.end(),
+              [](const auto* pFirst, const auto* pSecond) { return pFirst->size() < pSecond->size(); });
+    std::vector<uint32_t> candidates;
+    for (size_t i = 0; i < postingLists.size() - neededCount + 1; ++i) {
+        const auto& postings = *postingLists[i];
+        for (auto iter = postings.rbegin();
+             iter != postings.rend() && candidates.size() < HISTORY_SEARCH_MAX_FUZZY_CANDIDATES; ++iter) {
+            Phrase& phrase = m_phrases[iter->id];
+            if (isLive(*iter) && phrase.queryMark != m_queryMark) {
+                phrase.queryMark = m_queryMark;
+                candidates.push_back(iter->id);
+            }
+        }
+    }
+
+    struct ScoredMatch {
+        size_t sharedCount;
+        uint32_t sequence;
+        uint32_t id;
+    };
+    std::vector<ScoredMatch> matches;
+    // Most trigrams of a phrase are not in the query, a bit per hashed trigram rules them out before the search
+    TrigramFilter queryFilter;
+    for (uint32_t trigram : queryTrigrams) {
+        queryFilter.set(hashTrigram(trigram));
+    }
+    for (uint32_t id : candidates) {
+        const size_t sharedCount = countSharedTrigrams(m_phrases[id].text, queryTrigrams, queryFilter);
+        if (sharedCount >= neededCount) {
+            matches.push_back({sharedCount, m_phrases[id].sequence, id});
+        }
+    }
+    const size_t matchCount = std::min(matches.size(), maxResults - results.size());
+    std::partial_sort(matches.begin(), matches.begin() + matchCount, matches.end(),
+                      [](const ScoredMatch& first, const ScoredMatch& second) {
+                          return first.sharedCount != second.sharedCount ? first.sharedCount > second.sharedCount
+                                                                         : first.sequence > second.sequence;
+                      });
+    for (size_t i = 0; i < matchCount; ++i) {
+        results.push_back(matches[i].id);
+    }
+}
+
+size_t HistorySearchIndex::countSharedTrigrams(std::string_view text, const std::vector<uint32_t>& queryTrigrams,
+                                               const TrigramFilter& queryFilter) {
+    uint64_t sharedMask = 0;
+    for (size_t i = 0; i + 2 < text.size(); ++i) {
+        const uint32_t trigram =
+            packTrigram(toLowerAscii(text[i]), toLowerAscii(text[i + 1]), toLowerAscii(text[i + 2]));
+        if (!queryFilter.test(hashTrigram(trigram))) {
+            continue;
+        }
+        auto iter = std::lower_bound(queryTrigrams.begin(), queryTrigrams.end(), trigram);
+        if (iter != queryTrigrams.end() && *iter == trigram) {
+            sharedMask |= 1ull << (iter - queryTrigrams.begin());
+        }
+    }
+    return static_cast<size_t>(std::popcount(sharedMask));
+}
+
+void HistorySearchIndex::collectTrigrams(std::string_view text, std::vector<uint32_t>& trigrams) {
+    trigrams.clear();
+    for (size_t i = 0; i + 2 < text.size(); ++i) {
+        trigrams.push_back(packTrigram(toLowerAscii(text[i]), toLowerAscii(text[i + 1]), toLowerAscii(text[i + 2])));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
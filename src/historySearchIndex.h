@@ -0,0 +1,86 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Phrases deeper than this share the trie node of their first characters, longer queries are checked against the text
+inline constexpr size_t HISTORY_SEARCH_TRIE_DEPTH = 16;
+// Fuzzy matches share at least this part of the trigrams of the query
+inline constexpr double HISTORY_SEARCH_MIN_SHARED_TRIGRAMS = 0.5;
+// Phrases checked for fuzzy matches at most, the newest ones are checked first
+inline constexpr size_t HISTORY_SEARCH_MAX_FUZZY_CANDIDATES = 256;
+// Size of the filter of query trigrams, a power of two
+inline constexpr size_t HISTORY_SEARCH_TRIGRAM_FILTER_BITS = 1024;
+
+/*
+Incremental search index over history phrases: a prefix trie and a trigram index, both case-insensitive for ASCII.
+Prefix matches come first, newest first, then fuzzy matches by the number of trigrams shared with the query.
+
+Posting lists are kept in recency order by appending only. A phrase moved to the end gets new postings and its old
+ones go stale, they are skipped by queries and dropped when the whole index is rebuilt, which happens once stale
+postings outnumber live ones. So queries stop after the newest matches without sorting anything.
+*/
+class HistorySearchIndex {
+  public:
+    // The text must stay where it is until the phrase is removed
+    uint32_t add(std::string_view text);
+    // Makes the phrase the newest one
+    void touch(uint32_t id);
+    void remove(uint32_t id);
+    void clear();
+    // Texts of the best matches, valid until the phrases are changed
+    std::vector<std::string_view> search(std::string_view query, size_t maxResults);
+
+  private:
+    struct Posting {
+        uint32_t id;
+        // Recency of the phrase when the posting was added, stale once the phrase moves on
+        uint32_t sequence;
+    };
+
+    struct TrieNode {
+        std::vector<std::pair<char, uint32_t>> children;
+        std::vector<Posting> postings;
+    };
+
+    using TrigramFilter = std::bitset<HISTORY_SEARCH_TRIGRAM_FILTER_BITS>;
+
+    struct Phrase {
+        std::string_view text;
+        // Zero for free ids
+        uint32_t sequence = 0;
+        uint32_t postingCount = 0;
+        // Marks phrases already visited by the query with this number
+        uint32_t queryMark = 0;
+    };
+
+    std::vector<TrieNode> m_trie = std::vector<TrieNode>(1);
+    std::unordered_map<uint32_t, std::vector<Posting>> m_trigrams;
+    std::vector<Phrase> m_phrases;
+    std::vector<uint32_t> m_freeIds;
+    uint32_t m_nextSequence = 1;
+    uint32_t m_queryMark = 0;
+    size_t m_livePostingCount = 0;
+    size_t m_stalePostingCount = 0;
+    // Reused for the trigrams of each phrase, so indexing and queries do not allocate per phrase
+    std::vector<uint32_t> m_trigramBuffer;
+
+    void addPostings(uint32_t id);
+    void retirePostings(uint32_t id);
+    void rebuildIfStale();
+    // Drops the stale postings and renumbers the phrases from one in recency order
+    void rebuild();
+    bool isLive(const Posting& posting) const { return m_phrases[posting.id].sequence == posting.sequence; }
+    void searchPrefix(std::string_view query, size_t maxResults, std::vector<uint32_t>& results);
+    void searchFuzzy(std::string_view query, size_t maxResults, std::vector<uint32_t>& results);
+    // Query trigrams must be sorted, at most 64 of them, and set in the filter
+    static size_t countSharedTrigrams(std::string_view text, const std::vector<uint32_t>& queryTrigrams,
+                                      const TrigramFilter& queryFilter);
+    // Sorted without duplicates
+    static void collectTrigrams(std::string_view text, std::vector<uint32_t>& trigrams);
+};
@@ -1,37 +1,91 @@
 #include "historyStorage.h"
 
-#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+HistoryStorage::HistoryStorage(size_t capacity) : m_capacity(capacity) {}
 
 void HistoryStorage::push(const std::string& text) {
     if (text.empty()) {
         return;
     }
-    auto iter = std::find(m_messages.begin(), m_messages.end(), text);
-    if (iter != m_messages.end()) {
-        m_messages.erase(iter);
+    insert(text);
+    if (m_log != nullptr) {
+        m_log->append(text);
+        compactLogIfNeeded();
     }
-    m_messages.push_back(text);
 }
 
-std::string HistoryStorage::getNextByText(const std::string& text) {
-    if (m_messages.empty()) {
-        return "";
+bool HistoryStorage::openLog(const std::filesystem::path& path) {
+    // Phrases pushed before are newer than the saved ones, so they stay at the end
+    std::vector<std::string> pushedLines;
+    for (const Message& message : m_messages) {
+        pushedLines.push_back(message.text);
+    }
+    m_messages.clear();
+    m_indexByText.clear();
+    m_searchIndex.clear();
+    m_log = std::make_unique<HistoryLog>();
+    // Walking from the newest record, the first record of each phrase is its latest one. Only the phrases which fit
+    // are copied out of the mapping
+    const bool isOpened = m_log->open(path, [this](std::string_view text) {
+        if (m_capacity != 0 && m_messages.size() >= m_capacity) {
+            return false;
+        }
+        if (!m_indexByText.contains(text)) {
+            m_messages.push_front(Message{std::string(text), 0});
+            m_indexByText.emplace(m_messages.front().text, m_messages.begin());
+        }
+        return true;
+    });
+    if (!isOpened) {
+        m_log.reset();
+        m_messages.clear();
+        m_indexByText.clear();
+    }
+    // Indexed from the oldest, the search index keeps phrases in the order they were added
+    for (Message& message : m_messages) {
+        message.searchId = m_searchIndex.add(message.text);
+    }
+    for (auto& line : pushedLines) {
+        insert(line);
+        if (m_log != nullptr) {
+            m_log->append(line);
+        }
+    }
+    evictToFit();
+    compactLogIfNeeded();
+    return isOpened;
+}
+
+void HistoryStorage::insert(const std::string& text) {
+    auto indexIter = m_indexByText.find(text);
+    if (indexIter != m_indexByText.end()) {
+        // Relinking the node keeps the string, and so the key, where it is
+        m_messages.splice(m_messages.end(), m_messages, indexIter->second);
+        m_searchIndex.touch(indexIter->second->searchId);
+        return;
     }
+    m_messages.push_back(Message{text, 0});
+    m_messages.back().searchId = m_searchIndex.add(m_messages.back().text);
+    m_indexByText.emplace(m_messages.back().text, std::prev(m_messages.end()));
+    evictToFit();
+}
+
+std::string HistoryStorage::getNextByText(const std::string& text) {
     if (text.empty()) {
         return "";
     }
-    if (m_messages.size() == 1) {
+    auto indexIter = m_indexByText.find(text);
+    if (indexIter == m_indexByText.end()) {
         return "";
     }
-    auto iter = std::find(m_messages.begin(), m_messages.end(), text);
+    auto iter = std::next(indexIter->second);
     if (iter == m_messages.end()) {
         return "";
     }
-    auto idx = std::distance(m_messages.begin(), iter);
-    if (idx >= (m_messages.size() - 1)) {
-        return "";
-    }
-    return m_messages[idx + 1];
+    return iter->text;
 }
 
 std::string HistoryStorage::getPreviousByText(const std::string& text) {
@@ -39,15 +93,51 @@ std::string HistoryStorage::getPreviousByText(const std::string& text) {
         return "";
     }
     if (text.empty()) {
-        return m_messages[m_messages.size() - 1];
+        return m_messages.back().text;
     }
-    auto iter = std::find(m_messages.begin(), m_messages.end(), text);
-    if (iter == m_messages.end()) {
+    auto indexIter = m_indexByText.find(text);
+    if (indexIter == m_indexByText.end()) {
         return "";
     }
-    auto idx = std::distance(m_messages.begin(), iter);
-    if (idx <= 0) {
-        return m_messages[0];
+    auto iter = indexIter->second;
+    if (iter == m_messages.begin()) {
+        return iter->text;
+    }
+    return std::prev(iter)->text;
+}
+
+std::vector<std::string> HistoryStorage::search(const std::string& query, size_t maxResults) {
+    std::vector<std::string> results;
+    for (std::string_view text : m_searchIndex.search(query, maxResults)) {
+        results.emplace_back(text);
+    }
+    return results;
+}
+
+void HistoryStorage::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    evictToFit();
+}
+
+size_t HistoryStorage::size() const {
+    return m_messages.size();
+}
+
+void HistoryStorage::compactLogIfNeeded() {
+    if (m_log != nullptr && m_log->getRecordCount() > 2 * m_messages.size() + HISTORY_LOG_COMPACTION_SLACK) {
+        // Phrases in memory are exactly the latest ones of the log up to the capacity, so the writer finds the same
+        // ones in the file and evicted phrases are dropped from it as well
+        m_log->compact(m_messages.size(), m_capacity);
+    }
+}
+
+void HistoryStorage::evictToFit() {
+    if (m_capacity == 0) {
+        return;
+    }
+    while (m_messages.size() > m_capacity) {
+        m_indexByText.erase(m_messages.front().text);
+        m_searchIndex.remove(m_messages.front().searchId);
+        m_messages.pop_front();
     }
-    return m_messages[idx - 1];
 }
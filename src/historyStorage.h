@@ -1,18 +1,64 @@
 #pragma once
 
+#include "historyLog.h"
+#include "historySearchIndex.h"
 #include "singleton.h"
 
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+inline constexpr size_t HISTORY_DEFAULT_CAPACITY = 10000;
+// Superseded records the log may hold beyond twice the live phrases before it is compacted
+inline constexpr size_t HISTORY_LOG_COMPACTION_SLACK = 1000;
+inline constexpr size_t HISTORY_SEARCH_DEFAULT_RESULT_COUNT = 10;
+
+/*
+Spoken phrases from the oldest to the newest, without duplicates. Pushing a phrase again moves it to the end.
+Phrases are kept in a list and indexed by their text, so every operation takes constant time at any size.
+The oldest phrases are dropped once the capacity is exceeded.
+An optional log file keeps the phrases across restarts, and a search index finds them by prefix or fuzzily.
+*/
 class HistoryStorage {
   public:
+    explicit HistoryStorage(size_t capacity = HISTORY_DEFAULT_CAPACITY);
+
+    HistoryStorage(const HistoryStorage&) = delete;
+    HistoryStorage& operator=(const HistoryStorage&) = delete;
+
     void push(const std::string& text);
     std::string getNextByText(const std::string& text);
     std::string getPreviousByText(const std::string& text);
+    // Prefix matches newest first, then phrases sharing most of the trigrams of the query
+    std::vector<std::string> search(const std::string& query, size_t maxResults = HISTORY_SEARCH_DEFAULT_RESULT_COUNT);
+    // Zero keeps every phrase. Set it before opening the log, so phrases over it are not loaded at all
+    void setCapacity(size_t capacity);
+    // Loads the phrases saved before and saves new ones to the log from now on. Every loaded phrase is copied and
+    // indexed, so without a capacity the startup time grows with the whole saved history
+    bool openLog(const std::filesystem::path& path);
+    size_t size() const;
 
   private:
-    std::vector<std::string> m_messages;
+    struct Message {
+        std::string text;
+        uint32_t searchId;
+    };
+
+    std::list<Message> m_messages;
+    // Keys point to the strings in the list nodes, which never move
+    std::unordered_map<std::string_view, std::list<Message>::iterator> m_indexByText;
+    size_t m_capacity;
+    std::unique_ptr<HistoryLog> m_log;
+    HistorySearchIndex m_searchIndex;
+
+    void insert(const std::string& text);
+    void evictToFit();
+    void compactLogIfNeeded();
 };
 
 #define g_HistoryStorage CSingleton<HistoryStorage>::GetInstance()
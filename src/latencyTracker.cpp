@@ -0,0 +1,128 @@
+#include "latencyTracker.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
+#include <spdlog/spdlog.h>
+#include <string>
+
+static constexpr const char* LATENCY_STAGE_NAMES[LATENCY_STAGE_COUNT] = {"render start", "render end", "resampled",
+                                                                         "queued", "first frame"};
+
+void LatencyHistogram::record(std::chrono::microseconds latency) {
+    const uint64_t microseconds = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+    size_t index = 0;
+    if (microseconds < BUCKETS_PER_OCTAVE) {
+        // Below the first full octave every microsecond has its own bucket
+        index = static_cast<size_t>(microseconds);
+    } else {
+        const size_t octave = static_cast<size_t>(std::bit_width(microseconds)) - 1;
+        const size_t subBucket = (microseconds >> (octave - 3)) & (BUCKETS_PER_OCTAVE - 1);
+        index = std::min((octave - 2) * BUCKETS_PER_OCTAVE + subBucket, BUCKET_COUNT - 1);
+    }
+    m_counts[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Counts LatencyHistogram::getCounts() const {
+    Counts counts;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+std::chrono::microseconds LatencyHistogram::getPercentile(const Counts& counts, double fraction) {
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (; index < BUCKET_COUNT - 1; ++index) {
+        cumulative += counts[index];
+        if (cumulative >= target) {
+            break;
+        }
+    }
+    if (index < BUCKETS_PER_OCTAVE) {
+        return std::chrono::microseconds(index);
+    }
+    const size_t octave = index / BUCKETS_PER_OCTAVE + 2;
+    const size_t subBucket = index % BUCKETS_PER_OCTAVE;
+    const uint64_t lowerBound = (BUCKETS_PER_OCTAVE + subBucket) << (octave - 3);
+    return std::chrono::microseconds(lowerBound + (uint64_t(1) << (octave - 3)) - 1);
+}
+
+static void logStageStatistics(const char* period, LatencyStage stage, const LatencyHistogram::Counts& counts) {
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0) {
+        return;
+    }
+    auto toMilliseconds = [&](double fraction) {
+        return LatencyHistogram::getPercentile(counts, fraction).count() / 1000.0;
+    };
+    spdlog::info("Latency to {} {}: utterances: {}, p50: {:.1f} ms, p95: {:.1f} ms, p99: {:.1f} ms",
+                 LATENCY_STAGE_NAMES[static_cast<size_t>(stage)], period, total, toMilliseconds(0.50),
+                 toMilliseconds(0.95), toMilliseconds(0.99));
+}
+
+LatencyTracker::~LatencyTracker() {
+    m_loggingThread.request_stop();
+    if (m_loggingThread.joinable()) {
+        m_loggingThread.join();
+    }
+}
+
+void LatencyTracker::record(LatencyStage stage, LatencyClock::time_point requestTime, LatencyClock::time_point time) {
+    m_histograms[static_cast<size_t>(stage)].record(
+        std::chrono::duration_cast<std::chrono::microseconds>(time - requestTime));
+}
+
+void LatencyTracker::startPeriodicLogging(std::chrono::seconds interval) {
+    m_loggingThread.request_stop();
+    if (m_loggingThread.joinable()) {
+        m_loggingThread.join();
+    }
+    if (interval.count() <= 0) {
+        return;
+    }
+    m_loggingThread = std::jthread([this, interval](std::stop_token stopToken) {
+        std::mutex mutex;
+        std::condition_variable_any condition;
+        std::unique_lock lock(mutex);
+        while (!condition.wait_for(lock, stopToken, interval, [] { return false; }) && !stopToken.stop_requested()) {
+            logWindowStatistics();
+        }
+    });
+}
+
+void LatencyTracker::logStatistics() {
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; ++i) {
+        logStageStatistics("since startup", static_cast<LatencyStage>(i), m_histograms[i].getCounts());
+    }
+}
+
+LatencyHistogram::Counts LatencyTracker::getCounts(LatencyStage stage) const {
+    return m_histograms[static_cast<size_t>(stage)].getCounts();
+}
+
+void LatencyTracker::logWindowStatistics() {
+    std::lock_guard lock(m_windowMutex);
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; ++i) {
+        const auto counts = m_histograms[i].getCounts();
+        LatencyHistogram::Counts windowCounts;
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            windowCounts[bucket] = counts[bucket] - m_windowStartCounts[i][bucket];
+        }
+        logStageStatistics("over the last interval", static_cast<LatencyStage>(i), windowCounts);
+        m_windowStartCounts[i] = counts;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "singleton.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+using LatencyClock = std::chrono::steady_clock;
+
+// Pipeline stages of an utterance, each one is measured from the moment the utterance was requested
+enum class LatencyStage : size_t {
+    RenderStart,
+    RenderEnd,
+    Resampled,
+    // Handed to the playback queue, the feeder writes it to the ring of the running device from there
+    Queued,
+    // The device callback pulled the first frame which is not silent
+    FirstFrame,
+    Count,
+};
+
+inline constexpr size_t LATENCY_STAGE_COUNT = static_cast<size_t>(LatencyStage::Count);
+inline constexpr std::chrono::seconds LATENCY_DEFAULT_LOG_INTERVAL{60};
+
+/*
+Log-scale histogram of microseconds. Recording is lock-free, so it is safe in the audio device callback.
+Every octave is split into 8 buckets, so percentiles are within about 12% of the real value.
+*/
+class LatencyHistogram {
+  public:
+    static constexpr size_t BUCKETS_PER_OCTAVE = 8;
+    // Octaves up to 2^25 us, about half a minute. Anything longer is counted in the last bucket
+    static constexpr size_t BUCKET_COUNT = 23 * BUCKETS_PER_OCTAVE;
+    using Counts = std::array<uint64_t, BUCKET_COUNT>;
+
+    void record(std::chrono::microseconds latency);
+    Counts getCounts() const;
+
+    // Upper bound of the bucket the given fraction of samples falls into, zero without samples
+    static std::chrono::microseconds getPercentile(const Counts& counts, double fraction);
+
+  private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_counts{};
+};
+
+/*
+Rolling per-stage latency statistics of utterances. p50, p95 and p99 are logged periodically
+for the utterances since the previous report, and on demand for everything since startup.
+*/
+class LatencyTracker {
+  public:
+    ~LatencyTracker();
+
+    void record(LatencyStage stage, LatencyClock::time_point requestTime,
+                LatencyClock::time_point time = LatencyClock::now());
+    // Zero interval disables the periodic report
+    void startPeriodicLogging(std::chrono::seconds interval);
+    void logStatistics();
+    LatencyHistogram::Counts getCounts(LatencyStage stage) const;
+
+  private:
+    std::array<LatencyHistogram, LATENCY_STAGE_COUNT> m_histograms;
+    // Counts at the previous periodic report, the difference to them is the rolling window
+    std::mutex m_windowMutex;
+    std::array<LatencyHistogram::Counts, LATENCY_STAGE_COUNT> m_windowStartCounts{};
+    std::jthread m_loggingThread;
+
+    void logWindowStatistics();
+};
+
+#define g_LatencyTracker CSingleton<LatencyTracker>::GetInstance()
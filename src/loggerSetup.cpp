@@ -1,5 +1,7 @@
 #include "loggerSetup.h"
 
+#include "rtLogger.h"
+
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
@@ -13,9 +15,8 @@
 
 constexpr int LOGGER_THREAD_POOL_QUEUE_SIZE = 8192;
 constexpr int LOGGER_THREAD_POOL_BACKING_THREAD_COUNT = 1;
-constexpr const char* LOG_FORMAT = "%R Level: %l, Thread: %t, Message: %v";
 
-void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled) {
+void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled, const std::string& binaryLogFile) {
     try {
 #ifndef NDEBUG
         bool isDebugBuild = true;
@@ -29,7 +30,9 @@ void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled) {
         auto fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("sim.log", true);
         std::vector<spdlog::sink_ptr> sinks{consoleSink, fileSink};
         auto logger = std::make_shared<spdlog::async_logger>(
-            "simlogger", sinks.begin(), sinks.end(), spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+            "simlogger", sinks.begin(), sinks.end(), spdlog::thread_pool(),
+            // A full queue must not stall the thread which logs, the real-time logger reports how much was dropped
+            spdlog::async_overflow_policy::overrun_oldest);
         logger->set_pattern(LOG_FORMAT);
         if (isDebuggingEnabled || isDebugBuild) {
             logger->set_level(spdlog::level::trace);
@@ -44,6 +47,12 @@ void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled) {
         if (isDebuggingEnabled) {
             spdlog::debug("Log level is set to debug via command line parameter");
         }
+        if (!binaryLogFile.empty()) {
+            g_RtLogger.openBinaryLog(binaryLogFile);
+        }
+        g_RtLogger.start(logger->level());
         std::atexit(spdlog::shutdown);
+        // Handlers run in reverse order, so the real-time messages are drained before spdlog shuts down
+        std::atexit([] { g_RtLogger.stop(); });
     } catch (spdlog::spdlog_ex& ex) { std::cerr << "Unable to initialize logger: " << ex.what() << '\n'; }
 }
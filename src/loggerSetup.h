@@ -1,3 +1,9 @@
 #pragma once
 
-void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled);
+#include <string>
+
+// spdlog pattern of the console and file logs, sim_logdecode prints the binary log with it as well
+inline constexpr const char* LOG_FORMAT = "%R Level: %l, Thread: %t, Message: %v";
+
+// With a binary log file the real-time messages are written there unformatted, see RtLogger
+void InitializeLogging(int argc, char* argv[], bool isDebuggingEnabled, const std::string& binaryLogFile);
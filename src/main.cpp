@@ -1,3 +1,49 @@
+#include "batchRender.h"
+#include "cliOptions.h"
+#include "headless.h"
+#include "loggerSetup.h"
 #include "ui.h"
 
-wxIMPLEMENT_APP(MyApp);
+#ifdef _WIN32
+#include <stdlib.h>
+#endif
+
+// The entry point is our own, so the headless mode never initializes wxWidgets
+wxIMPLEMENT_APP_NO_MAIN(MyApp);
+
+// Returns the exit code when the program is done before the GUI could start
+static std::optional<int> runWithoutGui(int argc, char** argv) {
+    CliOptions& options = g_CliOptions;
+    if (auto exitCode = ParseCliOptions(argc, argv, options)) {
+        return exitCode;
+    }
+    if (options.isBatch()) {
+        AttachParentConsole();
+        InitializeLogging(argc, argv, options.isDebugEnabled, options.binaryLogFile);
+        return RunBatchRender(options);
+    }
+    if (!options.isHeadless()) {
+        // The GUI applies the options itself, after wxWidgets has initialized COM for its thread
+        return std::nullopt;
+    }
+    AttachParentConsole();
+    ApplyCliOptions(options, argc, argv);
+    return RunHeadless(options);
+}
+
+#ifdef _WIN32
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    // CLI11 reads the UTF-8 command line on its own, the narrow arguments only provide the count
+    if (auto exitCode = runWithoutGui(__argc, __argv)) {
+        return *exitCode;
+    }
+    return wxEntry(hInstance, hPrevInstance, lpCmdLine, nCmdShow);
+}
+#else
+int main(int argc, char* argv[]) {
+    if (auto exitCode = runWithoutGui(argc, argv)) {
+        return *exitCode;
+    }
+    return wxEntry(argc, argv);
+}
+#endif
@@ -0,0 +1,93 @@
+#include "mappedFile.h"
+
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    HANDLE fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->m_fileHandle = fileHandle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        return nullptr;
+    }
+    file->m_mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file->m_mappingHandle == nullptr) {
+        spdlog::error("Failed to create file mapping for {}: error {}", path.string(), GetLastError());
+        return nullptr;
+    }
+    file->m_pData = (const uint8_t*)MapViewOfFile(file->m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (file->m_pData == nullptr) {
+        spdlog::error("Failed to map {}: error {}", path.string(), GetLastError());
+        return nullptr;
+    }
+    file->m_size = static_cast<size_t>(fileSize.QuadPart);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (m_pData != nullptr) {
+        UnmapViewOfFile(m_pData);
+    }
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr) {
+        CloseHandle(m_fileHandle);
+    }
+}
+
+bool SyncFile(FILE* pFile) {
+    return fflush(pFile) == 0 && _commit(_fileno(pFile)) == 0;
+}
+#else
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    int fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return nullptr;
+    }
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fileDescriptor);
+        return nullptr;
+    }
+    void* pData = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fileDescriptor);
+    if (pData == MAP_FAILED) {
+        spdlog::error("Failed to map {}", path.string());
+        return nullptr;
+    }
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->m_pData = (const uint8_t*)pData;
+    file->m_size = static_cast<size_t>(fileStat.st_size);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (m_pData != nullptr) {
+        munmap((void*)m_pData, m_size);
+    }
+}
+
+bool SyncFile(FILE* pFile) {
+    return fflush(pFile) == 0 && fsync(fileno(pFile)) == 0;
+}
+#endif
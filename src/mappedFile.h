@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+// Read-only memory mapping of a whole file. Other handles may keep appending to the file while it is mapped
+class MappedFile {
+  public:
+    // Returns nullptr if the file does not exist, is empty or cannot be mapped
+    static std::shared_ptr<MappedFile> open(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    const uint8_t* data() const { return m_pData; }
+    size_t size() const { return m_size; }
+
+  private:
+    MappedFile() = default;
+
+    const uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
+
+// Flushes the C runtime buffers and asks the OS to write the file to the disk
+bool SyncFile(FILE* pFile);
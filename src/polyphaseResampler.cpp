@@ -0,0 +1,151 @@
+#include "polyphaseResampler.h"
+
+#include "cpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+// Larger tables stop fitting in the cache, such ratios are left to the linear resampler
+static constexpr ma_uint32 POLYPHASE_MAX_PHASES = 1024;
+static constexpr size_t POLYPHASE_HALF_TAP_COUNT = 32;
+static constexpr size_t POLYPHASE_MAX_HALF_TAP_COUNT = 256;
+// Fraction of the lower Nyquist frequency which is passed through, the rest is the transition band
+static constexpr double POLYPHASE_PASSBAND = 0.91;
+// Gives about 85 dB of stopband attenuation
+static constexpr double POLYPHASE_KAISER_BETA = 8.5;
+static constexpr size_t POLYPHASE_TAP_ALIGNMENT = 8;
+
+// Defined in the instruction set specific translation units, must not be called before the CPU is checked
+#ifdef SIM_CPU_X86
+DotProductKernel GetSse2DotProductKernel();
+DotProductKernel GetAvx2DotProductKernel();
+#endif
+
+static float dotProduct(const float* pSamples, const float* pCoefficients, size_t count) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        sum += pSamples[i] * pCoefficients[i];
+    }
+    return sum;
+}
+
+// Zeroth order modified Bessel function of the first kind, the series converges quickly for window arguments
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static double sinc(double x) {
+    if (std::abs(x) < 1e-9) {
+        return 1.0;
+    }
+    return std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+}
+
+DotProductKernel GetScalarDotProductKernel() {
+    return dotProduct;
+}
+
+DotProductKernel GetDotProductKernel() {
+    static const DotProductKernel kernel = [] {
+#ifdef SIM_CPU_X86
+        if (GetCpuFeatures().hasAvx2) {
+            return GetAvx2DotProductKernel();
+        }
+        if (GetCpuFeatures().hasSse2) {
+            return GetSse2DotProductKernel();
+        }
+#endif
+        return GetScalarDotProductKernel();
+    }();
+    return kernel;
+}
+
+std::unique_ptr<PolyphaseResampler> PolyphaseResampler::create(ma_uint32 sampleRateIn, ma_uint32 sampleRateOut) {
+    if (sampleRateIn == 0 || sampleRateOut == 0) {
+        return nullptr;
+    }
+    const ma_uint32 divisor = std::gcd(sampleRateIn, sampleRateOut);
+    const ma_uint32 interpolation = sampleRateOut / divisor;
+    if (interpolation > POLYPHASE_MAX_PHASES) {
+        return nullptr;
+    }
+
+    std::unique_ptr<PolyphaseResampler> resampler(new PolyphaseResampler());
+    resampler->m_sampleRateIn = sampleRateIn;
+    resampler->m_sampleRateOut = sampleRateOut;
+    resampler->m_interpolation = interpolation;
+    resampler->m_decimation = sampleRateIn / divisor;
+    resampler->m_dotProduct = GetDotProductKernel();
+
+    // When downsampling, the cutoff follows the output Nyquist frequency and the filter gets longer to keep
+    // the transition band equally sharp
+    const double bandwidth = std::min(1.0, (double)sampleRateOut / sampleRateIn);
+    const double cutoff = bandwidth * POLYPHASE_PASSBAND;
+    const size_t halfTapCount =
+        std::min(POLYPHASE_MAX_HALF_TAP_COUNT, (size_t)std::ceil(POLYPHASE_HALF_TAP_COUNT / bandwidth));
+    const size_t tapCount = halfTapCount * 2;
+    const size_t tapStride =
+        (tapCount + POLYPHASE_TAP_ALIGNMENT - 1) / POLYPHASE_TAP_ALIGNMENT * POLYPHASE_TAP_ALIGNMENT;
+    resampler->m_halfTapCount = halfTapCount;
+    resampler->m_tapStride = tapStride;
+    resampler->m_coefficients.assign(interpolation * tapStride, 0.0f);
+
+    const double windowNormalization = besselI0(POLYPHASE_KAISER_BETA);
+    std::vector<double> taps(tapCount);
+    for (ma_uint32 phase = 0; phase < interpolation; ++phase) {
+        double sum = 0.0;
+        for (size_t tap = 0; tap < tapCount; ++tap) {
+            // Distance in input frames between the tap and the position of the output sample
+            const double distance = (double)tap - (double)halfTapCount + 1.0 - (double)phase / interpolation;
+            const double windowPosition = distance / (double)halfTapCount;
+            const double window =
+                besselI0(POLYPHASE_KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - windowPosition * windowPosition))) /
+                windowNormalization;
+            taps[tap] = cutoff * sinc(cutoff * distance) * window;
+            sum += taps[tap];
+        }
+        // Every phase has unity gain at DC, otherwise the phases would modulate a constant signal
+        float* pPhase = &resampler->m_coefficients[phase * tapStride];
+        for (size_t tap = 0; tap < tapCount; ++tap) {
+            pPhase[tap] = (float)(taps[tap] / sum);
+        }
+    }
+    return resampler;
+}
+
+ma_uint64 PolyphaseResampler::getOutputFrameCount(ma_uint64 frameCountIn) const {
+    return (frameCountIn * m_interpolation + m_decimation - 1) / m_decimation;
+}
+
+void PolyphaseResampler::process(const float* pInput, ma_uint32 channels, ma_uint64 frameCountIn, float* pOutput) {
+    const ma_uint64 frameCountOut = getOutputFrameCount(frameCountIn);
+    // Each channel is filtered from its own contiguous copy, padded with silence so the taps never leave it
+    const size_t leftPadding = m_halfTapCount - 1;
+    m_channelBuffer.assign(leftPadding + frameCountIn + m_tapStride, 0.0f);
+    for (ma_uint32 channel = 0; channel < channels; ++channel) {
+        for (ma_uint64 frame = 0; frame < frameCountIn; ++frame) {
+            m_channelBuffer[leftPadding + frame] = pInput[frame * channels + channel];
+        }
+
+        ma_uint64 inputIndex = 0;
+        ma_uint32 phase = 0;
+        for (ma_uint64 frame = 0; frame < frameCountOut; ++frame) {
+            pOutput[frame * channels + channel] =
+                m_dotProduct(&m_channelBuffer[inputIndex], &m_coefficients[phase * m_tapStride], m_tapStride);
+            phase += m_decimation;
+            inputIndex += phase / m_interpolation;
+            phase %= m_interpolation;
+        }
+    }
+}
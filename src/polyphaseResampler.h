@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <miniaudio.h>
+#include <vector>
+
+// Sum of element-wise products of two float arrays
+using DotProductKernel = float (*)(const float* pSamples, const float* pCoefficients, size_t count);
+
+/*
+Windowed-sinc resampler for a fixed rational ratio. Every output sample is a dot product of the neighbouring
+input samples and one phase of a Kaiser-windowed sinc filter, with all phases precomputed on construction.
+It is slower than linear interpolation but keeps the images of upsampled speech far below audibility.
+*/
+class PolyphaseResampler {
+  public:
+    // Returns nullptr when the rates reduce to a ratio which needs too many phases for a table
+    static std::unique_ptr<PolyphaseResampler> create(ma_uint32 sampleRateIn, ma_uint32 sampleRateOut);
+
+    ma_uint32 getSampleRateIn() const { return m_sampleRateIn; }
+    ma_uint32 getSampleRateOut() const { return m_sampleRateOut; }
+    ma_uint64 getOutputFrameCount(ma_uint64 frameCountIn) const;
+    // Resamples a whole clip of interleaved frames, the signal is treated as silent outside of it
+    void process(const float* pInput, ma_uint32 channels, ma_uint64 frameCountIn, float* pOutput);
+
+  private:
+    PolyphaseResampler() = default;
+
+    ma_uint32 m_sampleRateIn = 0;
+    ma_uint32 m_sampleRateOut = 0;
+    // The reduced ratio: the output advances the input by decimation / interpolation frames
+    ma_uint32 m_interpolation = 0;
+    ma_uint32 m_decimation = 0;
+    size_t m_halfTapCount = 0;
+    // Taps of every phase, padded with zeros to a multiple of the widest SIMD register
+    size_t m_tapStride = 0;
+    std::vector<float> m_coefficients;
+    std::vector<float> m_channelBuffer;
+    DotProductKernel m_dotProduct = nullptr;
+};
+
+DotProductKernel GetDotProductKernel();
+DotProductKernel GetScalarDotProductKernel();
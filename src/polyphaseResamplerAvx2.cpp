@@ -0,0 +1,31 @@
+#include "polyphaseResampler.h"
+
+#include "cpuFeatures.h"
+
+// Built with AVX2 code generation enabled, see CMakeLists.txt. Nothing here may run before the CPU is checked
+#ifdef SIM_CPU_X86
+#include <immintrin.h>
+
+static float dotProduct(const float* pSamples, const float* pCoefficients, size_t count) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(pSamples + i), _mm256_loadu_ps(pCoefficients + i)));
+        sum1 = _mm256_add_ps(sum1,
+                             _mm256_mul_ps(_mm256_loadu_ps(pSamples + i + 8), _mm256_loadu_ps(pCoefficients + i + 8)));
+    }
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(pSamples + i), _mm256_loadu_ps(pCoefficients + i)));
+    }
+    const __m256 sum = _mm256_add_ps(sum0, sum1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half) + GetScalarDotProductKernel()(pSamples + i, pCoefficients + i, count - i);
+}
+
+DotProductKernel GetAvx2DotProductKernel() {
+    return dotProduct;
+}
+#endif
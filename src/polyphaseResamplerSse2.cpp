@@ -0,0 +1,25 @@
+#include "polyphaseResampler.h"
+
+#include "cpuFeatures.h"
+
+#ifdef SIM_CPU_X86
+#include <emmintrin.h>
+
+static float dotProduct(const float* pSamples, const float* pCoefficients, size_t count) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(pSamples + i), _mm_loadu_ps(pCoefficients + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pSamples + i + 4), _mm_loadu_ps(pCoefficients + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + GetScalarDotProductKernel()(pSamples + i, pCoefficients + i, count - i);
+}
+
+DotProductKernel GetSse2DotProductKernel() {
+    return dotProduct;
+}
+#endif
@@ -0,0 +1,45 @@
+#include "rtLogFormat.h"
+
+#include <format>
+#include <type_traits>
+
+std::string FormatRtLogMessage(std::string_view format, std::span<const RtLogArg> args) {
+    std::string text;
+    size_t argIndex = 0;
+    // Replacement fields are formatted one by one, the argument types are only known at run time
+    for (size_t i = 0; i < format.size(); ++i) {
+        const char character = format[i];
+        if ((character == '{' || character == '}') && i + 1 < format.size() && format[i + 1] == character) {
+            text += character;
+            ++i;
+        } else if (character == '{') {
+            const size_t fieldEnd = format.find('}', i);
+            if (fieldEnd == std::string_view::npos || argIndex == args.size()) {
+                return text + "(malformed real-time log message) " + std::string(format);
+            }
+            // Automatic numbering only, an explicit index is dropped and the field takes the next argument
+            const std::string_view spec = format.substr(i + 1, fieldEnd - i - 1);
+            const size_t specStart = spec.find(':');
+            const std::string field =
+                std::format("{{{}}}", specStart == std::string_view::npos ? "" : spec.substr(specStart));
+            try {
+                text += std::visit(
+                    [&field](auto value) {
+                        if constexpr (std::is_same_v<decltype(value), const char*>) {
+                            std::string_view string = value != nullptr ? value : "(null)";
+                            return std::vformat(field, std::make_format_args(string));
+                        } else {
+                            return std::vformat(field, std::make_format_args(value));
+                        }
+                    },
+                    args[argIndex++]);
+            } catch (const std::format_error&) {
+                return text + "(malformed real-time log message) " + std::string(format);
+            }
+            i = fieldEnd;
+        } else {
+            text += character;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+
+inline constexpr size_t RT_LOG_MAX_ARGS = 4;
+
+// Arguments are kept as values and formatted later, so only numbers and string literals are accepted
+using RtLogArg = std::variant<int64_t, uint64_t, double, bool, const char*>;
+
+// Formats a deferred log message, used by the real-time logger and by sim_logdecode for the binary log
+std::string FormatRtLogMessage(std::string_view format, std::span<const RtLogArg> args);
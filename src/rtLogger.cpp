@@ -0,0 +1,192 @@
+#include "rtLogger.h"
+
+#include <spdlog/async.h>
+#include <spdlog/details/os.h>
+#include <span>
+
+// Messages moved out of a ring at once by the drain thread
+static constexpr size_t DRAIN_BATCH_SIZE = 64;
+
+// Plain values, so bound threads register no thread_local destructor, which could allocate on the audio threads
+static thread_local RtLogger::ThreadRing* t_pRing = nullptr;
+static thread_local bool t_isRingBound = false;
+
+RtLogger::RtLogger() : m_rings(std::make_unique<ThreadRing[]>(RT_LOG_MAX_THREADS)) {}
+
+RtLogger::~RtLogger() {
+    stop();
+}
+
+void RtLogger::start(spdlog::level::level_enum level) {
+    m_level = level;
+    if (!m_drainThread.joinable()) {
+        m_drainThread = std::jthread([this](std::stop_token stopToken) { drain(stopToken); });
+    }
+}
+
+bool RtLogger::openBinaryLog(const std::filesystem::path& path) {
+    if (m_drainThread.joinable()) {
+        return false;
+    }
+    if (!m_binaryLog.open(path)) {
+        return false;
+    }
+    spdlog::info("Real-time log messages are written to the binary log {}", path.string());
+    return true;
+}
+
+void RtLogger::stop() {
+    m_level = spdlog::level::off;
+    if (m_drainThread.joinable()) {
+        // The drain thread empties the rings once more before it stops
+        m_drainThread.request_stop();
+        m_drainThread.join();
+    }
+    m_binaryLog.close();
+}
+
+void RtLogger::write(Message& message) {
+    // Cached per thread by spdlog
+    message.threadId = spdlog::details::os::thread_id();
+    ThreadRing* pRing = getThreadRing();
+    if (pRing == nullptr) {
+        m_unclaimedDroppedCount.fetch_add(1, std::memory_order_relaxed);
+    } else if (pRing->messages.write(&message, 1) == 0) {
+        pRing->droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+RtLogger::ThreadRing* RtLogger::acquireThreadRing() {
+    return claimThreadRing();
+}
+
+void RtLogger::releaseThreadRing(ThreadRing* pRing) {
+    if (pRing != nullptr) {
+        pRing->isClaimed.store(false, std::memory_order_release);
+    }
+}
+
+void RtLogger::bindThreadRing(ThreadRing* pRing) {
+    t_pRing = pRing;
+    t_isRingBound = true;
+}
+
+RtLogger::ThreadRing* RtLogger::getThreadRing() {
+    if (t_pRing != nullptr || t_isRingBound) {
+        return t_pRing;
+    }
+    // Frees the ring when the thread exits, so short-lived threads do not use them all up. Only threads which claim
+    // their own ring get it
+    struct ThreadRingClaim {
+        ThreadRing* pRing = nullptr;
+        ~ThreadRingClaim() {
+            if (pRing != nullptr) {
+                pRing->isClaimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+    thread_local ThreadRingClaim t_claim;
+    t_pRing = claimThreadRing();
+    t_claim.pRing = t_pRing;
+    return t_pRing;
+}
+
+RtLogger::ThreadRing* RtLogger::claimThreadRing() {
+    for (size_t i = 0; i < RT_LOG_MAX_THREADS; ++i) {
+        bool isClaimed = false;
+        if (m_rings[i].isClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acquire)) {
+            return &m_rings[i];
+        }
+    }
+    return nullptr;
+}
+
+void RtLogger::drain(std::stop_token stopToken) {
+    while (true) {
+        {
+            std::unique_lock lock(m_drainMutex);
+            m_drainCondition.wait_for(lock, stopToken, RT_LOG_DRAIN_INTERVAL, [] { return false; });
+        }
+        // Checked before draining, so the messages logged before the stop are all in the last pass
+        const bool isStopping = stopToken.stop_requested();
+        drainRings();
+        if (isStopping) {
+            return;
+        }
+    }
+}
+
+void RtLogger::drainRings() {
+    auto* pLogger = spdlog::default_logger_raw();
+    if (pLogger == nullptr) {
+        return;
+    }
+    auto pAsyncLogger = std::dynamic_pointer_cast<spdlog::async_logger>(spdlog::default_logger());
+    std::array<Message, DRAIN_BATCH_SIZE> messages;
+    uint64_t droppedCount = m_unclaimedDroppedCount.exchange(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < RT_LOG_MAX_THREADS; ++i) {
+        ThreadRing& ring = m_rings[i];
+        // Released rings are drained as well, their last messages may still be waiting
+        size_t messageCount;
+        while ((messageCount = ring.messages.read(messages.data(), messages.size())) != 0) {
+            for (size_t j = 0; j < messageCount; ++j) {
+                const Message& message = messages[j];
+                if (m_binaryLog.isOpen()) {
+                    const auto time =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(message.time.time_since_epoch());
+                    m_binaryLog.writeMessage(time.count(), message.threadId, message.level, message.format,
+                                             std::span(message.args.data(), message.argCount));
+                } else {
+                    logMessage(*pLogger, pAsyncLogger, message);
+                }
+            }
+        }
+        droppedCount += ring.droppedCount.exchange(0, std::memory_order_relaxed);
+    }
+    if (droppedCount != 0) {
+        if (m_binaryLog.isOpen()) {
+            const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                spdlog::log_clock::now().time_since_epoch());
+            m_binaryLog.writeDropped(time.count(), spdlog::details::os::thread_id(), droppedCount);
+        } else {
+            pLogger->warn("Dropped {} real-time log messages, the rings were full", droppedCount);
+        }
+    }
+    m_binaryLog.flush();
+
+    // The regular logger drops its oldest messages rather than block whoever logs
+    if (auto threadPool = spdlog::thread_pool(); threadPool != nullptr) {
+        const size_t overrunCount = threadPool->overrun_counter();
+        if (overrunCount != m_reportedOverrunCount) {
+            pLogger->warn("Dropped {} log messages, the logger queue was full", overrunCount - m_reportedOverrunCount);
+            m_reportedOverrunCount = overrunCount;
+        }
+    }
+}
+
+void RtLogger::logMessage(spdlog::logger& logger, const std::shared_ptr<spdlog::async_logger>& pAsyncLogger,
+                          const Message& message) {
+    if (!logger.should_log(message.level)) {
+        return;
+    }
+    const std::string text = FormatRtLogMessage(message.format, std::span(message.args.data(), message.argCount));
+    // Under the thread which logged it rather than the drain thread, the same line sim_logdecode prints for it
+    spdlog::details::log_msg logMessage(message.time, spdlog::source_loc{}, logger.name(), message.level, text);
+    logMessage.thread_id = message.threadId;
+    if (pAsyncLogger != nullptr) {
+        if (auto pThreadPool = spdlog::thread_pool(); pThreadPool != nullptr) {
+            // The policy InitializeLogging gives the logger, a full queue must not stall the drain thread either
+            auto pWorker = pAsyncLogger;
+            pThreadPool->post_log(std::move(pWorker), logMessage, spdlog::async_overflow_policy::overrun_oldest);
+        }
+        return;
+    }
+    for (const auto& sink : logger.sinks()) {
+        if (sink->should_log(message.level)) {
+            sink->log(logMessage);
+        }
+    }
+    if (message.level >= logger.flush_level()) {
+        logger.flush();
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "binaryLog.h"
+#include "rtLogFormat.h"
+#include "singleton.h"
+#include "spscRingBuffer.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <spdlog/async_logger.h>
+#include <spdlog/spdlog.h>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Threads which can log at once, a thread beyond them has its messages counted as dropped
+inline constexpr size_t RT_LOG_MAX_THREADS = 16;
+// Messages a thread can have waiting, newer ones are dropped and counted until the drain thread catches up
+inline constexpr size_t RT_LOG_MESSAGES_PER_THREAD = 512;
+inline constexpr std::chrono::milliseconds RT_LOG_DRAIN_INTERVAL{50};
+
+// Messages below this spdlog level are compiled out, e.g. SPDLOG_LEVEL_INFO drops the debug ones of the audio callback
+#ifndef SIM_RT_LOG_LEVEL
+#define SIM_RT_LOG_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+/*
+String the logger may keep a pointer to, the binary log also identifies it by its address. Only a constant expression
+constructs one, so format strings and string arguments are literals and a buffer on the stack does not compile.
+Format strings convert implicitly, string arguments are wrapped in it explicitly.
+*/
+struct RtLogLiteral {
+    template <size_t N> consteval RtLogLiteral(const char (&text)[N]) : pText(text) {}
+
+    const char* pText;
+};
+
+template <class T>
+concept RtLoggable =
+    std::is_arithmetic_v<std::remove_cvref_t<T>> || std::is_same_v<std::remove_cvref_t<T>, RtLogLiteral>;
+
+/*
+Logging for threads which must never block, above all the audio device callbacks. A message is stored as its format
+string literal and argument values in a preallocated ring of the calling thread, without formatting, allocating or
+locking. A drain thread formats the messages and passes them to spdlog with the time and thread they were logged at.
+A thread claims a free ring with its first message and frees it when it exits, except for threads which are bound to
+a ring acquired for them in advance, such as the audio device callbacks. Messages which find the ring full are
+dropped, and the drain thread logs how many were lost, as well as the messages the regular async logger overran.
+With a binary log the drain thread writes the messages there unformatted instead, see BinaryLogWriter.
+*/
+class RtLogger {
+  public:
+    struct ThreadRing;
+
+    RtLogger();
+    ~RtLogger();
+
+    // Starts draining into the default spdlog logger, messages below the level are skipped right away
+    void start(spdlog::level::level_enum level);
+    // Must be called before start, the messages then go to this file instead of the default logger
+    bool openBinaryLog(const std::filesystem::path& path);
+    // Drains what is left and stops, meant to be called before spdlog shuts down
+    void stop();
+
+    template <RtLoggable... Args> void log(spdlog::level::level_enum level, RtLogLiteral format, Args... args) {
+        static_assert(sizeof...(Args) <= RT_LOG_MAX_ARGS, "Too many arguments for a real-time log message");
+        if (level < m_level.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Message message{spdlog::log_clock::now(), 0, level, format.pText, sizeof...(Args), {toArg(args)...}};
+        write(message);
+    }
+
+    // Ring for a thread which is started by someone else and must not register a thread exit handler, nullptr when
+    // all are claimed
+    ThreadRing* acquireThreadRing();
+    // The thread bound to the ring must have exited, its waiting messages are still drained
+    void releaseThreadRing(ThreadRing* pRing);
+    // The calling thread logs into this ring from now on, or counts its messages as dropped if it is nullptr
+    void bindThreadRing(ThreadRing* pRing);
+
+  private:
+    struct Message {
+        spdlog::log_clock::time_point time;
+        size_t threadId;
+        spdlog::level::level_enum level;
+        const char* format;
+        size_t argCount;
+        std::array<RtLogArg, RT_LOG_MAX_ARGS> args;
+    };
+
+  public:
+    // Only passed around outside of the logger
+    struct ThreadRing {
+        SpscRingBuffer<Message> messages{RT_LOG_MESSAGES_PER_THREAD};
+        std::atomic<bool> isClaimed = false;
+        std::atomic<size_t> threadId = 0;
+        std::atomic<uint64_t> droppedCount = 0;
+    };
+
+  private:
+    std::atomic<int> m_level = spdlog::level::off;
+    std::unique_ptr<ThreadRing[]> m_rings;
+    // Messages of threads which found no free ring
+    std::atomic<uint64_t> m_unclaimedDroppedCount = 0;
+    // Only used by the drain thread
+    size_t m_reportedOverrunCount = 0;
+    BinaryLogWriter m_binaryLog;
+    std::mutex m_drainMutex;
+    std::condition_variable_any m_drainCondition;
+    std::jthread m_drainThread;
+
+    template <class T> static RtLogArg toArg(T value) {
+        if constexpr (std::is_same_v<T, RtLogLiteral>) {
+            return value.pText;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<double>(value);
+        } else if constexpr (std::is_signed_v<T>) {
+            return static_cast<int64_t>(value);
+        } else {
+            return static_cast<uint64_t>(value);
+        }
+    }
+
+    void write(Message& message);
+    ThreadRing* getThreadRing();
+    ThreadRing* claimThreadRing();
+    void drain(std::stop_token stopToken);
+    void drainRings();
+    static void logMessage(spdlog::logger& logger, const std::shared_ptr<spdlog::async_logger>& pAsyncLogger,
+                           const Message& message);
+};
+
+#define g_RtLogger CSingleton<RtLogger>::GetInstance()
+
+// Hot path logging, the arguments are not even evaluated below the compile-time level
+#define SIM_RT_LOG(logLevel, logFormat, ...)                                                                           \
+    do {                                                                                                               \
+        if constexpr (logLevel >= SIM_RT_LOG_LEVEL) {                                                                  \
+            g_RtLogger.log(static_cast<spdlog::level::level_enum>(logLevel), logFormat __VA_OPT__(, ) __VA_ARGS__);    \
+        }                                                                                                              \
+    } while (false)
+#define SIM_RT_TRACE(format, ...) SIM_RT_LOG(SPDLOG_LEVEL_TRACE, format __VA_OPT__(, ) __VA_ARGS__)
+#define SIM_RT_DEBUG(format, ...) SIM_RT_LOG(SPDLOG_LEVEL_DEBUG, format __VA_OPT__(, ) __VA_ARGS__)
+#define SIM_RT_INFO(format, ...) SIM_RT_LOG(SPDLOG_LEVEL_INFO, format __VA_OPT__(, ) __VA_ARGS__)
+#define SIM_RT_WARN(format, ...) SIM_RT_LOG(SPDLOG_LEVEL_WARN, format __VA_OPT__(, ) __VA_ARGS__)
+#define SIM_RT_ERROR(format, ...) SIM_RT_LOG(SPDLOG_LEVEL_ERROR, format __VA_OPT__(, ) __VA_ARGS__)
@@ -0,0 +1,120 @@
+#include "sampleConversion.h"
+
+#include "cpuFeatures.h"
+
+#include <cstdint>
+#include <cstring>
+
+// Defined in the instruction set specific translation units, which are built with their own compiler flags.
+// They must not be called before the CPU is checked
+#ifdef SIM_CPU_X86
+const SampleConversionKernels* GetSse2SampleConversionTable();
+const SampleConversionKernels* GetAvx2SampleConversionTable();
+#endif
+
+static void convertU8ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const uint8_t*)pInput;
+    const float scale = gain / 128.0f;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        pOutput[i] = (float)((int)pSamples[i] - 128) * scale;
+    }
+}
+
+static void convertS16ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int16_t*)pInput;
+    const float scale = gain / 32768.0f;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        pOutput[i] = (float)pSamples[i] * scale;
+    }
+}
+
+static void convertS24ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pBytes = (const uint8_t*)pInput;
+    const float scale = gain / 2147483648.0f;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        // Little-endian 24-bit sample placed in the upper bytes of a 32-bit one keeps its sign
+        const uint32_t sample = (uint32_t)pBytes[i * 3] << 8 | (uint32_t)pBytes[i * 3 + 1] << 16 |
+                                (uint32_t)pBytes[i * 3 + 2] << 24;
+        pOutput[i] = (float)(int32_t)sample * scale;
+    }
+}
+
+static void convertS32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int32_t*)pInput;
+    const float scale = gain / 2147483648.0f;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        pOutput[i] = (float)pSamples[i] * scale;
+    }
+}
+
+static void convertF32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const float*)pInput;
+    if (gain == 1.0f) {
+        std::memcpy(pOutput, pSamples, sampleCount * sizeof(float));
+        return;
+    }
+    for (size_t i = 0; i < sampleCount; ++i) {
+        pOutput[i] = pSamples[i] * gain;
+    }
+}
+
+SampleConversionKernel SampleConversionKernels::get(ma_format format) const {
+    switch (format) {
+        case ma_format_u8:
+            return u8;
+        case ma_format_s16:
+            return s16;
+        case ma_format_s24:
+            return s24;
+        case ma_format_s32:
+            return s32;
+        case ma_format_f32:
+            return f32;
+        default:
+            return nullptr;
+    }
+}
+
+const SampleConversionKernels& GetScalarSampleConversionKernels() {
+    static const SampleConversionKernels kernels{"scalar",        convertU8ToF32,  convertS16ToF32,
+                                                 convertS24ToF32, convertS32ToF32, convertF32ToF32};
+    return kernels;
+}
+
+const SampleConversionKernels* GetSse2SampleConversionKernels() {
+#ifdef SIM_CPU_X86
+    return GetCpuFeatures().hasSse2 ? GetSse2SampleConversionTable() : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const SampleConversionKernels* GetAvx2SampleConversionKernels() {
+#ifdef SIM_CPU_X86
+    return GetCpuFeatures().hasAvx2 ? GetAvx2SampleConversionTable() : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const SampleConversionKernels& GetSampleConversionKernels() {
+    static const SampleConversionKernels& kernels = []() -> const SampleConversionKernels& {
+        if (const auto* pKernels = GetAvx2SampleConversionKernels()) {
+            return *pKernels;
+        }
+        if (const auto* pKernels = GetSse2SampleConversionKernels()) {
+            return *pKernels;
+        }
+        return GetScalarSampleConversionKernels();
+    }();
+    return kernels;
+}
+
+bool ConvertSamplesToF32(const void* pInput, ma_format format, float* pOutput, size_t sampleCount, float gain) {
+    SampleConversionKernel kernel = GetSampleConversionKernels().get(format);
+    if (kernel == nullptr) {
+        return false;
+    }
+    kernel(pInput, pOutput, sampleCount, gain);
+    return true;
+}
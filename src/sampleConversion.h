@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <miniaudio.h>
+
+// Converts interleaved samples of one format to f32 and multiplies them by the gain. Channels do not matter here
+using SampleConversionKernel = void (*)(const void* pInput, float* pOutput, size_t sampleCount, float gain);
+
+struct SampleConversionKernels {
+    const char* name;
+    SampleConversionKernel u8;
+    SampleConversionKernel s16;
+    SampleConversionKernel s24;
+    SampleConversionKernel s32;
+    SampleConversionKernel f32;
+
+    SampleConversionKernel get(ma_format format) const;
+};
+
+// The fastest kernels the CPU supports, detected once
+const SampleConversionKernels& GetSampleConversionKernels();
+const SampleConversionKernels& GetScalarSampleConversionKernels();
+// Return nullptr when the build target or the CPU does not support the instruction set
+const SampleConversionKernels* GetSse2SampleConversionKernels();
+const SampleConversionKernels* GetAvx2SampleConversionKernels();
+
+// Returns false for formats without a kernel
+bool ConvertSamplesToF32(const void* pInput, ma_format format, float* pOutput, size_t sampleCount, float gain);
@@ -0,0 +1,80 @@
+#include "sampleConversion.h"
+
+#include "cpuFeatures.h"
+
+// Built with AVX2 code generation enabled, see CMakeLists.txt. Nothing here may run before the CPU is checked
+#ifdef SIM_CPU_X86
+#include <cstdint>
+#include <immintrin.h>
+
+static void convertU8ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const uint8_t*)pInput;
+    const __m256 scale = _mm256_set1_ps(gain / 128.0f);
+    const __m256i bias = _mm256_set1_epi32(128);
+    size_t i = 0;
+    for (; i + 16 <= sampleCount; i += 16) {
+        const __m256i low = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pSamples + i)));
+        const __m256i high = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pSamples + i + 8)));
+        _mm256_storeu_ps(pOutput + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(low, bias)), scale));
+        _mm256_storeu_ps(pOutput + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(high, bias)), scale));
+    }
+    GetScalarSampleConversionKernels().u8(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertS16ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int16_t*)pInput;
+    const __m256 scale = _mm256_set1_ps(gain / 32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= sampleCount; i += 16) {
+        const __m256i low = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSamples + i)));
+        const __m256i high = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSamples + i + 8)));
+        _mm256_storeu_ps(pOutput + i, _mm256_mul_ps(_mm256_cvtepi32_ps(low), scale));
+        _mm256_storeu_ps(pOutput + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(high), scale));
+    }
+    GetScalarSampleConversionKernels().s16(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertS24ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pBytes = (const uint8_t*)pInput;
+    const __m256 scale = _mm256_set1_ps(gain / 2147483648.0f);
+    // Moves each 3-byte sample into the upper bytes of a 32-bit lane, the zeroed low byte keeps the value scaled
+    const __m256i shuffle = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3,
+                                             4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    size_t i = 0;
+    // Each 16-byte load uses 12 bytes, so the last one reads 4 bytes past the 8 samples of the iteration
+    for (; i + 10 <= sampleCount; i += 8) {
+        const __m128i low = _mm_loadu_si128((const __m128i*)(pBytes + i * 3));
+        const __m128i high = _mm_loadu_si128((const __m128i*)(pBytes + i * 3 + 12));
+        const __m256i samples = _mm256_shuffle_epi8(_mm256_set_m128i(high, low), shuffle);
+        _mm256_storeu_ps(pOutput + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+    GetScalarSampleConversionKernels().s24(pBytes + i * 3, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertS32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int32_t*)pInput;
+    const __m256 scale = _mm256_set1_ps(gain / 2147483648.0f);
+    size_t i = 0;
+    for (; i + 8 <= sampleCount; i += 8) {
+        const __m256i samples = _mm256_loadu_si256((const __m256i*)(pSamples + i));
+        _mm256_storeu_ps(pOutput + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+    GetScalarSampleConversionKernels().s32(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertF32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const float*)pInput;
+    const __m256 scale = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= sampleCount; i += 8) {
+        _mm256_storeu_ps(pOutput + i, _mm256_mul_ps(_mm256_loadu_ps(pSamples + i), scale));
+    }
+    GetScalarSampleConversionKernels().f32(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+const SampleConversionKernels* GetAvx2SampleConversionTable() {
+    static const SampleConversionKernels kernels{"avx2",          convertU8ToF32,  convertS16ToF32,
+                                                 convertS24ToF32, convertS32ToF32, convertF32ToF32};
+    return &kernels;
+}
+#endif
@@ -0,0 +1,77 @@
+#include "sampleConversion.h"
+
+#include "cpuFeatures.h"
+
+#ifdef SIM_CPU_X86
+#include <cstdint>
+#include <emmintrin.h>
+
+static void convertU8ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const uint8_t*)pInput;
+    const __m128 scale = _mm_set1_ps(gain / 128.0f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= sampleCount; i += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(pSamples + i));
+        const __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias);
+        const __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(bytes, zero), bias);
+        // Sign extension of 16-bit lanes: duplicate them into 32-bit ones and shift back arithmetically
+        _mm_storeu_ps(pOutput + i,
+                      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16)), scale));
+        _mm_storeu_ps(pOutput + i + 4,
+                      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16)), scale));
+        _mm_storeu_ps(pOutput + i + 8,
+                      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16)), scale));
+        _mm_storeu_ps(pOutput + i + 12,
+                      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16)), scale));
+    }
+    GetScalarSampleConversionKernels().u8(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertS16ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int16_t*)pInput;
+    const __m128 scale = _mm_set1_ps(gain / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= sampleCount; i += 8) {
+        const __m128i samples = _mm_loadu_si128((const __m128i*)(pSamples + i));
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(pOutput + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    GetScalarSampleConversionKernels().s16(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertS32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const int32_t*)pInput;
+    const __m128 scale = _mm_set1_ps(gain / 2147483648.0f);
+    size_t i = 0;
+    for (; i + 4 <= sampleCount; i += 4) {
+        const __m128i samples = _mm_loadu_si128((const __m128i*)(pSamples + i));
+        _mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+    }
+    GetScalarSampleConversionKernels().s32(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+static void convertF32ToF32(const void* pInput, float* pOutput, size_t sampleCount, float gain) {
+    const auto* pSamples = (const float*)pInput;
+    const __m128 scale = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= sampleCount; i += 4) {
+        _mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_loadu_ps(pSamples + i), scale));
+    }
+    GetScalarSampleConversionKernels().f32(pSamples + i, pOutput + i, sampleCount - i, gain);
+}
+
+const SampleConversionKernels* GetSse2SampleConversionTable() {
+    // Packed 24-bit samples need a byte shuffle, which SSE2 lacks, so they stay scalar here
+    static const SampleConversionKernels kernels{"sse2",
+                                                 convertU8ToF32,
+                                                 convertS16ToF32,
+                                                 GetScalarSampleConversionKernels().s24,
+                                                 convertS32ToF32,
+                                                 convertF32ToF32};
+    return &kernels;
+}
+#endif
@@ -1,97 +1,234 @@
 #include "speech.h"
 
 #include "audio.h"
-#include "unsupportedVoicesFilter.h"
+#include "rtLogger.h"
+#include "speechDiskCache.h"
+#include "textSplitter.h"
+#include "traceRecorder.h"
 
+#include <chrono>
 #include <climits>
 #include <cstdlib>
+#include <format>
 #include <memory>
 #include <spdlog/spdlog.h>
+#include <utility>
 
-static constexpr size_t SRAL_MAX_VOICE_NAME_LEN = 128;
+Speech::Speech() = default;
 
-Speech::Speech() {
-    spdlog::debug("SRAL instance initializing");
-    if (!SRAL_IsInitialized()) {
-        SRAL_Initialize(SRAL_ENGINE_NVDA | SRAL_ENGINE_JAWS | SRAL_ENGINE_UIA);
-        spdlog::debug("SRAL initialized");
-    }
-}
-
-Speech::~Speech() {
-    spdlog::debug("Uninitializing SRAL");
-    if (SRAL_IsInitialized()) {
-        SRAL_Uninitialize();
-        spdlog::debug("SRAL uninitialized");
-    }
-}
+Speech::~Speech() = default;
 
 Speech& Speech::GetInstance() {
     static Speech instance;
     return instance;
 }
 
+void Speech::setEngine(std::unique_ptr<ISpeechEngine> engine) {
+    std::lock_guard lock(m_engineMutex);
+    spdlog::debug("Using {} speech engine", engine != nullptr ? engine->getName() : "no");
+    m_engine = std::move(engine);
+    m_voiceIndex = 0;
+    m_voiceIdentity.clear();
+    m_rate = 0;
+    m_unsupportedVoiceIndices.clear();
+    m_unsupportedVoiceIsSet = false;
+}
+
 std::vector<std::string> Speech::getVoicesList() {
-    int voiceCount = 0;
-    if (!SRAL_GetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_COUNT, &voiceCount)) {
-        spdlog::error("Failed to get voice count from SRAL.");
-        return {}; // Return an empty vector on failure.
-    }
-    if (voiceCount <= 0) {
-        return {};
-    }
-    std::vector<SRAL_VoiceInfo> voiceInfos(voiceCount);
-    if (!SRAL_GetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_PROPERTIES, voiceInfos.data())) {
-        spdlog::error("Failed to get voice properties from SRAL.");
+    std::lock_guard lock(m_engineMutex);
+    if (m_engine == nullptr) {
+        spdlog::error("No speech engine is set");
         return {};
     }
+    auto engineVoices = m_engine->getVoices();
+    m_unsupportedVoiceIndices.clear();
     std::vector<std::string> voices;
-    voices.reserve(voiceCount);
-    for (size_t i = 0; i < voiceInfos.size(); ++i) {
-        bool isSupported = CheckVoiceIsSupported(voiceInfos[i]);
-        if (!isSupported) {
+    voices.reserve(engineVoices.size());
+    for (size_t i = 0; i < engineVoices.size(); ++i) {
+        if (!engineVoices[i].isSupported) {
             m_unsupportedVoiceIndices.push_back(i);
         }
-        voices.emplace_back(std::format("{}{}", isSupported ? "" : "!Not supported ", voiceInfos[i].name));
+        voices.emplace_back(std::format("{}{}", engineVoices[i].isSupported ? "" : "!Not supported ",
+                                        engineVoices[i].name));
     }
     return voices;
 }
 
-bool Speech::speak(const char* text) {
+bool Speech::speak(const char* text, std::stop_token stopToken, LatencyClock::time_point requestTime) {
+    SIM_TRACE_ZONE("Speech::speak");
+    std::lock_guard lock(m_engineMutex);
+    if (m_engine == nullptr) {
+        spdlog::error("No speech engine is set");
+        return false;
+    }
+    const PlaybackPolicy policy = m_playbackPolicy;
+    if (policy == PlaybackPolicy::DropIfBusy && g_Audio.isBusy()) {
+        SIM_RT_DEBUG("Speech dropped, the previous one is still playing");
+        return true;
+    }
+    applyPendingSettings();
     if (m_unsupportedVoiceIsSet) {
         spdlog::warn("Trying to speak with unsupported voice");
         return false;
     }
-    uint64_t bufferSize = 0;
-    int channels = 0;
-    int sampleRate = 0;
-    int bitsPerSample = 0;
-    auto* data = SRAL_SpeakToMemoryEx(SRAL_ENGINE_SAPI, text, &bufferSize, &channels, &sampleRate, &bitsPerSample);
-    if (data == nullptr) {
-        spdlog::error("SRAL_SpeakToMemoryEx returned nullptr");
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::string> chunks;
+    if (m_isStreamingEnabled) {
+        chunks = SplitTextIntoChunks(text);
+    }
+    if (chunks.empty()) {
+        chunks.emplace_back(text);
+    }
+
+    bool isSpoken = true;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (stopToken.stop_requested()) {
+            SIM_RT_DEBUG("Speech cancelled after {} of {} chunks", i, chunks.size());
+            break;
+        }
+        // Only the first chunk interrupts, the rest follow it
+        if (!speakChunk(chunks[i].c_str(), i == 0 ? std::optional(requestTime) : std::nullopt,
+                        i == 0 && policy == PlaybackPolicy::Interrupt)) {
+            isSpoken = false;
+            break;
+        }
+        if (i == 0) {
+            const std::chrono::duration<double, std::milli> timeToFirstAudio =
+                std::chrono::steady_clock::now() - startTime;
+            SIM_RT_DEBUG("Time to first audio: {:.1f} ms, chunks: {}", timeToFirstAudio.count(), chunks.size());
+        }
+    }
+    return isSpoken;
+}
+
+bool Speech::speakChunk(const char* text, std::optional<LatencyClock::time_point> requestTime,
+                        bool isInterrupting) {
+    SIM_TRACE_ZONE("Speech::speakChunk");
+    auto recordLatency = [&](LatencyStage stage) {
+        if (requestTime.has_value()) {
+            g_LatencyTracker.record(stage, *requestTime);
+        }
+    };
+    SpeechCacheKey cacheKey{m_voiceIdentity, m_rate, g_Audio.getPlaybackSampleRate(), g_Audio.getResampler(),
+                            SpeechCache::normalizeText(text)};
+    if (auto cachedSpeech = m_cache.find(cacheKey)) {
+        auto stats = m_cache.getStats();
+        SIM_RT_DEBUG("Speech cache hit, hits: {}, disk hits: {}, misses: {}, evictions: {}", stats.hits,
+                     stats.diskHits, stats.misses, stats.evictions);
+        SIM_RT_DEBUG("Speech cache holds {} entries of {} bytes, the disk cache {} entries of {} bytes",
+                     stats.entryCount, stats.sizeInBytes, stats.diskEntryCount, stats.diskSizeInBytes);
+        if (isInterrupting) {
+            g_Audio.stop();
+        }
+        if (!g_Audio.queueRenderedSpeech(std::move(cachedSpeech), requestTime)) {
+            return false;
+        }
+        recordLatency(LatencyStage::Queued);
+        return true;
+    }
+
+    recordLatency(LatencyStage::RenderStart);
+    auto synthesized = m_engine->synthesize(text);
+    if (!synthesized.has_value()) {
+        return false;
+    }
+    recordLatency(LatencyStage::RenderEnd);
+    if (synthesized->channels <= 0 || synthesized->sampleRate <= 0 || synthesized->bitsPerSample <= 0) {
+        spdlog::error("{} engine returned invalid audio metadata: channels={}, sampleRate={}, bitsPerSample={}",
+                      m_engine->getName(), synthesized->channels, synthesized->sampleRate,
+                      synthesized->bitsPerSample);
+        free(synthesized->pData);
         return false;
     }
-    if (channels <= 0 || sampleRate <= 0 || bitsPerSample <= 0) {
-        spdlog::error("SRAL returned invalid audio metadata: channels={}, sampleRate={}, bitsPerSample={}", channels,
-                      sampleRate, bitsPerSample);
-        free(data);
+    auto speech = g_Audio.renderAudioData(synthesized->channels, synthesized->sampleRate, synthesized->bitsPerSample,
+                                          synthesized->bufferSize, synthesized->pData);
+    if (speech == nullptr) {
         return false;
     }
-    return g_Audio.playAudioData(channels, sampleRate, bitsPerSample, bufferSize, data);
+    recordLatency(LatencyStage::Resampled);
+    // Stopped right before queueing, so the previous speech keeps playing while this one is synthesized
+    if (isInterrupting) {
+        g_Audio.stop();
+    }
+    // Chunks are queued back to back into the playback stream, so they are joined without gaps
+    bool isQueued = g_Audio.queueRenderedSpeech(speech, requestTime);
+    if (isQueued) {
+        recordLatency(LatencyStage::Queued);
+    }
+    // Only the memory cache is updated here, the disk cache writes the speech on its own thread
+    m_cache.insert(cacheKey, std::move(speech));
+    return isQueued;
 }
 
 bool Speech::setRate(uint64_t rate) {
-    return SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_SPEECH_RATE, &rate);
+    std::lock_guard lock(m_settingsMutex);
+    m_pendingRate = rate;
+    return true;
+}
+
+void Speech::setStreamingEnabled(bool isEnabled) {
+    m_isStreamingEnabled = isEnabled;
+}
+
+void Speech::setPlaybackPolicy(PlaybackPolicy policy) {
+    m_playbackPolicy = policy;
+}
+
+void Speech::setCacheBudget(size_t budgetInBytes) {
+    m_cache.setBudget(budgetInBytes);
+}
+
+bool Speech::openDiskCache(size_t budgetInBytes) {
+    return m_cache.openDiskCache(SPEECH_DISK_CACHE_INDEX_FILE, SPEECH_DISK_CACHE_DATA_FILE, budgetInBytes);
+}
+
+SpeechCacheStats Speech::getCacheStats() {
+    return m_cache.getStats();
 }
 
 bool Speech::setVoice(uint64_t idx) {
-    m_unsupportedVoiceIsSet = std::find(m_unsupportedVoiceIndices.begin(), m_unsupportedVoiceIndices.end(), idx) !=
-                              m_unsupportedVoiceIndices.end();
-    if (!SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_INDEX, &idx)) {
-        spdlog::error("Failed to set voice index to {}", idx);
-        return false;
-    }
-    int newIdx = 0;
-    SRAL_GetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_INDEX, &newIdx);
+    std::lock_guard lock(m_settingsMutex);
+    m_pendingVoiceIndex = idx;
     return true;
 }
+
+void Speech::applyPendingSettings() {
+    std::optional<uint64_t> rate;
+    std::optional<uint64_t> voiceIndex;
+    {
+        std::lock_guard lock(m_settingsMutex);
+        rate = std::exchange(m_pendingRate, std::nullopt);
+        voiceIndex = std::exchange(m_pendingVoiceIndex, std::nullopt);
+    }
+    if (voiceIndex.has_value()) {
+        m_unsupportedVoiceIsSet = std::find(m_unsupportedVoiceIndices.begin(), m_unsupportedVoiceIndices.end(),
+                                            *voiceIndex) != m_unsupportedVoiceIndices.end();
+    }
+    if (voiceIndex.has_value() && !m_unsupportedVoiceIsSet) {
+        if (m_engine->setVoice(*voiceIndex)) {
+            m_voiceIndex = *voiceIndex;
+            m_voiceIdentity = getVoiceIdentity(m_voiceIndex);
+        } else {
+            spdlog::error("Failed to set voice index to {}", *voiceIndex);
+        }
+    }
+    if (m_voiceIdentity.empty()) {
+        m_voiceIdentity = getVoiceIdentity(m_voiceIndex);
+    }
+    if (rate.has_value()) {
+        if (m_engine->setRate(static_cast<int64_t>(*rate))) {
+            m_rate = static_cast<int64_t>(*rate);
+        } else {
+            spdlog::error("Failed to set speech rate to {}", *rate);
+        }
+    }
+}
+
+std::string Speech::getVoiceIdentity(uint64_t voiceIndex) {
+    auto voices = m_engine->getVoices();
+    if (voiceIndex >= voices.size()) {
+        // Never matches a named voice, so phrases of an unknown voice are not mixed with any other
+        return std::format("{}/#{}", m_engine->getName(), voiceIndex);
+    }
+    return std::format("{}/{}", m_engine->getName(), voices[voiceIndex].name);
+}
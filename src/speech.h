@@ -1,6 +1,15 @@
 #pragma once
 
-#include <SRAL.h>
+#include "audio.h"
+#include "latencyTracker.h"
+#include "speechCache.h"
+#include "speechEngine.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
 #include <vector>
 
@@ -13,11 +22,25 @@ class Speech {
     Speech(Speech&&) = delete;
     Speech& operator=(Speech&&) = delete;
 
+    // Replaces the engine and forgets the settings of the old one. Meant to be called once at startup
+    void setEngine(std::unique_ptr<ISpeechEngine> engine);
     std::vector<std::string> getVoicesList();
-    bool speak(const char* text);
+    // Blocks until the text is synthesized and queued for playback, so it should be called from the speech worker.
+    // Latencies of the first chunk are recorded from the request time
+    bool speak(const char* text, std::stop_token stopToken = {},
+               LatencyClock::time_point requestTime = LatencyClock::now());
+    // Rate and voice changes are applied right before the next synthesis, so they never wait for a running one
     bool setRate(uint64_t rate);
     bool setVolume(uint64_t volume);
     bool setVoice(uint64_t idx);
+    // In streaming mode text is spoken sentence by sentence, so playback starts after the first one is synthesized
+    void setStreamingEnabled(bool isEnabled);
+    // Decides what happens to new speech while the previous one is still playing
+    void setPlaybackPolicy(PlaybackPolicy policy);
+    void setCacheBudget(size_t budgetInBytes);
+    // Keeps rendered phrases in files next to the program, so they survive restarts. Zero budget disables it
+    bool openDiskCache(size_t budgetInBytes);
+    SpeechCacheStats getCacheStats();
 
   private:
     Speech();
@@ -25,6 +48,24 @@ class Speech {
 
     int m_defaultRate;
     int m_defaultVolume;
-    bool m_unsupportedVoiceIsSet = false;
+    std::atomic<bool> m_isStreamingEnabled = false;
+    std::atomic<PlaybackPolicy> m_playbackPolicy = PlaybackPolicy::Queue;
+    std::mutex m_engineMutex;
+    // Guarded by m_engineMutex, the flag is updated when the speech worker applies the pending voice
     std::vector<uint64_t> m_unsupportedVoiceIndices;
+    bool m_unsupportedVoiceIsSet = false;
+    std::unique_ptr<ISpeechEngine> m_engine;
+    std::mutex m_settingsMutex;
+    std::optional<uint64_t> m_pendingRate;
+    std::optional<uint64_t> m_pendingVoiceIndex;
+    // Settings the engine currently uses, they are part of the cache key
+    uint64_t m_voiceIndex = 0;
+    // Engine and voice name of m_voiceIndex, empty until the first synthesis with the engine
+    std::string m_voiceIdentity;
+    int64_t m_rate = 0;
+    SpeechCache m_cache;
+
+    void applyPendingSettings();
+    std::string getVoiceIdentity(uint64_t voiceIndex);
+    bool speakChunk(const char* text, std::optional<LatencyClock::time_point> requestTime, bool isInterrupting);
 };
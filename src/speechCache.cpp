@@ -0,0 +1,132 @@
+#include "speechCache.h"
+
+#include "speechDiskCache.h"
+
+#include <functional>
+
+static size_t combineHash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+size_t SpeechCacheKeyHash::operator()(const SpeechCacheKey& key) const {
+    size_t hash = std::hash<std::string>()(key.text);
+    hash = combineHash(hash, std::hash<std::string>()(key.voice));
+    hash = combineHash(hash, std::hash<int64_t>()(key.rate));
+    hash = combineHash(hash, std::hash<ma_uint32>()(key.sampleRate));
+    return combineHash(hash, std::hash<uint32_t>()(static_cast<uint32_t>(key.resampler)));
+}
+
+SpeechCache::SpeechCache(size_t budgetInBytes) : m_budgetInBytes(budgetInBytes) {
+}
+
+SpeechCache::~SpeechCache() = default;
+
+void SpeechCache::setBudget(size_t budgetInBytes) {
+    std::lock_guard lock(m_mutex);
+    m_budgetInBytes = budgetInBytes;
+    evictToFit(m_budgetInBytes);
+}
+
+bool SpeechCache::openDiskCache(const std::filesystem::path& indexPath, const std::filesystem::path& dataPath,
+                                size_t budgetInBytes) {
+    std::lock_guard lock(m_mutex);
+    m_diskCache.reset();
+    if (budgetInBytes == 0) {
+        return true;
+    }
+    auto diskCache = std::make_unique<SpeechDiskCache>();
+    if (!diskCache->open(indexPath, dataPath, budgetInBytes)) {
+        return false;
+    }
+    m_diskCache = std::move(diskCache);
+    return true;
+}
+
+RenderedSpeechPtr SpeechCache::find(const SpeechCacheKey& key) {
+    std::lock_guard lock(m_mutex);
+    auto iter = m_index.find(key);
+    if (iter != m_index.end()) {
+        m_hits++;
+        m_entries.splice(m_entries.begin(), m_entries, iter->second);
+        return iter->second->speech;
+    }
+    if (m_diskCache != nullptr) {
+        if (auto speech = m_diskCache->find(key)) {
+            m_diskHits++;
+            insertToMemory(key, speech);
+            return speech;
+        }
+    }
+    m_misses++;
+    return nullptr;
+}
+
+void SpeechCache::insert(const SpeechCacheKey& key, RenderedSpeechPtr speech) {
+    if (speech == nullptr) {
+        return;
+    }
+    std::lock_guard lock(m_mutex);
+    if (m_diskCache != nullptr) {
+        m_diskCache->insert(key, speech);
+    }
+    insertToMemory(key, std::move(speech));
+}
+
+SpeechCacheStats SpeechCache::getStats() {
+    std::lock_guard lock(m_mutex);
+    return SpeechCacheStats{m_hits,
+                            m_misses,
+                            m_evictions,
+                            m_entries.size(),
+                            m_sizeInBytes,
+                            m_diskHits,
+                            m_diskCache != nullptr ? m_diskCache->getEntryCount() : 0,
+                            m_diskCache != nullptr ? static_cast<size_t>(m_diskCache->getSizeInBytes()) : 0};
+}
+
+void SpeechCache::insertToMemory(const SpeechCacheKey& key, RenderedSpeechPtr speech) {
+    const size_t speechSize = speech->sizeInBytes();
+    if (speechSize > m_budgetInBytes) {
+        return;
+    }
+
+    auto iter = m_index.find(key);
+    if (iter != m_index.end()) {
+        m_sizeInBytes -= iter->second->speech->sizeInBytes();
+        m_entries.erase(iter->second);
+        m_index.erase(iter);
+    }
+
+    evictToFit(m_budgetInBytes - speechSize);
+    m_entries.push_front(Entry{key, std::move(speech)});
+    m_index.emplace(key, m_entries.begin());
+    m_sizeInBytes += speechSize;
+}
+
+std::string SpeechCache::normalizeText(std::string_view text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool isPendingSpace = false;
+    for (char c : text) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            isPendingSpace = !normalized.empty();
+            continue;
+        }
+        if (isPendingSpace) {
+            normalized.push_back(' ');
+            isPendingSpace = false;
+        }
+        normalized.push_back(c);
+    }
+    return normalized;
+}
+
+void SpeechCache::evictToFit(size_t budgetInBytes) {
+    while (m_sizeInBytes > budgetInBytes && !m_entries.empty()) {
+        auto& entry = m_entries.back();
+        m_sizeInBytes -= entry.speech->sizeInBytes();
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+        m_evictions++;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "audio.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+inline constexpr size_t SPEECH_CACHE_DEFAULT_BUDGET_BYTES = 16 * 1024 * 1024;
+
+struct SpeechCacheKey {
+    // Engine and voice name rather than the voice index, which changes when voices are installed or removed
+    std::string voice;
+    int64_t rate;
+    ma_uint32 sampleRate;
+    AudioResampler resampler;
+    std::string text;
+
+    bool operator==(const SpeechCacheKey&) const = default;
+};
+
+struct SpeechCacheKeyHash {
+    size_t operator()(const SpeechCacheKey& key) const;
+};
+
+struct SpeechCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entryCount;
+    size_t sizeInBytes;
+    uint64_t diskHits;
+    size_t diskEntryCount;
+    size_t diskSizeInBytes;
+};
+
+class SpeechDiskCache;
+
+/*
+In-memory LRU cache of rendered speech, so repeated phrases are played without calling the TTS engine.
+The least recently used entries are evicted when the total PCM size exceeds the byte budget.
+An optional disk cache below it keeps phrases across restarts, its hits are promoted to memory.
+*/
+class SpeechCache {
+  public:
+    explicit SpeechCache(size_t budgetInBytes = SPEECH_CACHE_DEFAULT_BUDGET_BYTES);
+    ~SpeechCache();
+
+    // Zero budget disables the cache
+    void setBudget(size_t budgetInBytes);
+    // Zero budget closes the disk cache
+    bool openDiskCache(const std::filesystem::path& indexPath, const std::filesystem::path& dataPath,
+                       size_t budgetInBytes);
+    RenderedSpeechPtr find(const SpeechCacheKey& key);
+    void insert(const SpeechCacheKey& key, RenderedSpeechPtr speech);
+    SpeechCacheStats getStats();
+
+    // Trims the text and collapses whitespace runs, so insignificant differences do not cause misses
+    static std::string normalizeText(std::string_view text);
+
+  private:
+    struct Entry {
+        SpeechCacheKey key;
+        RenderedSpeechPtr speech;
+    };
+
+    std::mutex m_mutex;
+    // The most recently used entry is at the front
+    std::list<Entry> m_entries;
+    std::unordered_map<SpeechCacheKey, std::list<Entry>::iterator, SpeechCacheKeyHash> m_index;
+    size_t m_budgetInBytes;
+    size_t m_sizeInBytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+    uint64_t m_diskHits = 0;
+    std::unique_ptr<SpeechDiskCache> m_diskCache;
+
+    void insertToMemory(const SpeechCacheKey& key, RenderedSpeechPtr speech);
+    void evictToFit(size_t budgetInBytes);
+};
@@ -0,0 +1,528 @@
+#include "speechDiskCache.h"
+
+#include "checksum.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <string>
+
+static constexpr char INDEX_FILE_MAGIC[8] = {'S', 'I', 'M', 'S', 'P', 'C', 'I', '1'};
+static constexpr char DATA_FILE_MAGIC[8] = {'S', 'I', 'M', 'S', 'P', 'C', 'B', '1'};
+static constexpr uint32_t RECORD_TYPE_PUT = 1;
+static constexpr uint32_t RECORD_TYPE_EVICT = 2;
+// Keeps samples in the mapping aligned for SIMD loads
+static constexpr uint64_t DATA_ALIGNMENT = 16;
+static constexpr uint32_t MAX_TEXT_SIZE = 1024 * 1024;
+static constexpr uint32_t MAX_VOICE_SIZE = 4096;
+
+struct SpeechDiskCacheFileHeader {
+    char magic[8];
+    uint64_t storeId;
+};
+
+// Followed by voiceSize bytes of the voice and textSize bytes of the key text
+struct SpeechDiskCacheIndexRecord {
+    uint32_t type;
+    uint32_t textSize;
+    uint32_t voiceSize;
+    uint32_t reserved;
+    int64_t rate;
+    uint32_t sampleRate;
+    uint32_t format;
+    uint32_t channels;
+    uint32_t resampler;
+    uint64_t frameCount;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    // FNV-1a of the record with this field zeroed, followed by the voice and the text
+    uint64_t checksum;
+};
+
+static_assert(sizeof(SpeechDiskCacheFileHeader) == 16);
+static_assert(sizeof(SpeechDiskCacheIndexRecord) == 72);
+
+static FILE* openFile(const std::filesystem::path& path, const char* mode) {
+#ifdef _WIN32
+    std::wstring wideMode(mode, mode + std::strlen(mode));
+    return _wfopen(path.c_str(), wideMode.c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+static uint64_t generateStoreId() {
+    std::random_device randomDevice;
+    const uint64_t time = std::chrono::steady_clock::now().time_since_epoch().count();
+    return ((uint64_t)randomDevice() << 32 | randomDevice()) ^ time;
+}
+
+static uint64_t alignDataOffset(uint64_t offset) {
+    return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+static bool writeHeader(FILE* pFile, const char (&magic)[8], uint64_t storeId) {
+    SpeechDiskCacheFileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.storeId = storeId;
+    return fwrite(&header, sizeof(header), 1, pFile) == 1;
+}
+
+static bool readHeader(FILE* pFile, const char (&magic)[8], uint64_t& storeId) {
+    SpeechDiskCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, pFile) != 1 || std::memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+        return false;
+    }
+    storeId = header.storeId;
+    return true;
+}
+
+// Pads the file with zeros up to the aligned offset
+static bool writePadding(FILE* pFile, uint64_t fileSize, uint64_t alignedOffset) {
+    static constexpr uint8_t zeros[DATA_ALIGNMENT] = {};
+    const size_t paddingSize = static_cast<size_t>(alignedOffset - fileSize);
+    return paddingSize == 0 || fwrite(zeros, 1, paddingSize, pFile) == paddingSize;
+}
+
+static uint64_t computeRecordChecksum(SpeechDiskCacheIndexRecord record, const std::string& voice,
+                                      const std::string& text) {
+    record.checksum = 0;
+    return Fnv1a64(text.data(), text.size(), Fnv1a64(voice.data(), voice.size(), Fnv1a64(&record, sizeof(record))));
+}
+
+SpeechDiskCache::~SpeechDiskCache() {
+    close();
+}
+
+bool SpeechDiskCache::open(const std::filesystem::path& indexPath, const std::filesystem::path& dataPath,
+                           size_t budgetInBytes) {
+    close();
+    m_indexPath = indexPath;
+    m_dataPath = dataPath;
+    m_budgetInBytes = budgetInBytes;
+
+    auto startTime = std::chrono::steady_clock::now();
+    bool isReady = load();
+    if (isReady) {
+        const uint64_t deadBytes = m_dataFileSize - sizeof(SpeechDiskCacheFileHeader) - m_liveBytes;
+        if (m_liveBytes > m_budgetInBytes || deadBytes > m_budgetInBytes / 4) {
+            isReady = compact();
+        }
+    }
+    if (!isReady) {
+        spdlog::info("Creating a new speech disk cache at {}", m_dataPath.string());
+        m_entries.clear();
+        m_entriesBySequence.clear();
+        m_liveBytes = 0;
+        if (!create()) {
+            spdlog::error("Failed to create the speech disk cache");
+            return false;
+        }
+    }
+    if (!openForAppend()) {
+        spdlog::error("Failed to open the speech disk cache for writing");
+        close();
+        return false;
+    }
+    m_writtenDataSize = m_dataFileSize;
+    m_writer = std::jthread([this](std::stop_token stopToken) { writeTasks(stopToken); });
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    spdlog::info("Speech disk cache opened in {} ms, entries: {}, bytes: {}", duration.count(), m_entries.size(),
+                 m_liveBytes);
+    return true;
+}
+
+void SpeechDiskCache::close() {
+    if (m_writer.joinable()) {
+        // The writer finishes the queued speech before it stops
+        m_writer.request_stop();
+        m_writer.join();
+    }
+    if (m_pIndexFile != nullptr) {
+        fclose(m_pIndexFile);
+        m_pIndexFile = nullptr;
+    }
+    if (m_pDataFile != nullptr) {
+        fclose(m_pDataFile);
+        m_pDataFile = nullptr;
+    }
+    // Speech that is still playing keeps its own reference to the mapping
+    m_mapping.reset();
+    m_entries.clear();
+    m_entriesBySequence.clear();
+    m_liveBytes = 0;
+    m_pendingKeys.clear();
+    m_pendingBytes = 0;
+    m_dataFileSize = 0;
+    m_writtenDataSize = 0;
+    m_isDataFileFull = false;
+    m_isWriteFailed = false;
+}
+
+RenderedSpeechPtr SpeechDiskCache::find(const SpeechCacheKey& key) {
+    if (m_pDataFile == nullptr) {
+        return nullptr;
+    }
+    Entry entry;
+    {
+        std::lock_guard lock(m_entriesMutex);
+        auto iter = m_entries.find(key);
+        if (iter == m_entries.end()) {
+            return nullptr;
+        }
+        entry = iter->second;
+    }
+    // Entries appended after the file was mapped are not visible until it is mapped again
+    if (m_mapping == nullptr || entry.dataOffset + entry.dataSize > m_mapping->size()) {
+        m_mapping = MappedFile::open(m_dataPath);
+        if (m_mapping == nullptr || entry.dataOffset + entry.dataSize > m_mapping->size()) {
+            spdlog::error("Speech disk cache entry is outside of the data file");
+            return nullptr;
+        }
+    }
+
+    auto speech = std::make_shared<RenderedSpeech>();
+    speech->format = entry.format;
+    speech->channels = entry.channels;
+    speech->sampleRate = entry.sampleRate;
+    speech->frameCount = entry.frameCount;
+    speech->pData = m_mapping->data() + entry.dataOffset;
+    speech->storage = m_mapping;
+    return speech;
+}
+
+void SpeechDiskCache::insert(const SpeechCacheKey& key, RenderedSpeechPtr speech) {
+    if (!m_writer.joinable() || m_isWriteFailed || key.text.size() > MAX_TEXT_SIZE ||
+        key.voice.size() > MAX_VOICE_SIZE) {
+        return;
+    }
+    const uint64_t speechSize = speech->sizeInBytes();
+    if (speechSize == 0 || speechSize > m_budgetInBytes) {
+        return;
+    }
+    // Space of evicted entries is reclaimed only on the next start, so stop growing the file at some point.
+    // Compacting now is not an option, speech which is still playing keeps the old file mapped
+    const uint64_t dataOffset = alignDataOffset(m_dataFileSize);
+    if (dataOffset + speechSize > 2 * (uint64_t)m_budgetInBytes) {
+        if (!m_isDataFileFull) {
+            m_isDataFileFull = true;
+            spdlog::warn("Speech disk cache data file reached {} bytes, new phrases are kept in memory only until "
+                         "it is compacted on the next start",
+                         m_dataFileSize);
+        }
+        return;
+    }
+
+    WriteTask task{key, std::move(speech), Entry{}, {}};
+    {
+        std::lock_guard lock(m_entriesMutex);
+        // Only written entries can be evicted, so a burst of phrases bigger than the budget keeps the rest in memory
+        if (m_entries.contains(key) || m_pendingKeys.contains(key) || m_pendingBytes + speechSize > m_budgetInBytes) {
+            return;
+        }
+        while (m_liveBytes + m_pendingBytes + speechSize > m_budgetInBytes && !m_entriesBySequence.empty()) {
+            const SpeechCacheKey oldestKey = m_entriesBySequence.begin()->second;
+            removeEntry(oldestKey);
+            task.evictedKeys.push_back(oldestKey);
+        }
+        m_pendingKeys.insert(key);
+        m_pendingBytes += speechSize;
+    }
+    task.entry = Entry{task.speech->format, task.speech->channels, task.speech->sampleRate, task.speech->frameCount,
+                       dataOffset,          speechSize,             m_nextSequence++};
+    m_dataFileSize = dataOffset + speechSize;
+    {
+        std::lock_guard lock(m_tasksMutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_tasksCondition.notify_one();
+}
+
+size_t SpeechDiskCache::getEntryCount() const {
+    std::lock_guard lock(m_entriesMutex);
+    return m_entries.size();
+}
+
+uint64_t SpeechDiskCache::getSizeInBytes() const {
+    std::lock_guard lock(m_entriesMutex);
+    return m_liveBytes;
+}
+
+bool SpeechDiskCache::load() {
+    std::error_code error;
+    if (!std::filesystem::exists(m_indexPath, error) || !std::filesystem::exists(m_dataPath, error)) {
+        return false;
+    }
+    const uint64_t indexFileSize = std::filesystem::file_size(m_indexPath, error);
+    if (error) {
+        return false;
+    }
+    m_dataFileSize = std::filesystem::file_size(m_dataPath, error);
+    if (error) {
+        return false;
+    }
+
+    FILE* pDataFile = openFile(m_dataPath, "rb");
+    if (pDataFile == nullptr) {
+        return false;
+    }
+    uint64_t dataStoreId = 0;
+    const bool isDataHeaderValid = readHeader(pDataFile, DATA_FILE_MAGIC, dataStoreId);
+    fclose(pDataFile);
+
+    FILE* pIndexFile = openFile(m_indexPath, "rb");
+    if (pIndexFile == nullptr) {
+        return false;
+    }
+    // Different ids mean a crash between the two renames of a compaction
+    if (!isDataHeaderValid || !readHeader(pIndexFile, INDEX_FILE_MAGIC, m_storeId) || m_storeId != dataStoreId) {
+        spdlog::warn("Speech disk cache files are damaged or do not belong together, discarding them");
+        fclose(pIndexFile);
+        return false;
+    }
+
+    uint64_t validIndexSize = sizeof(SpeechDiskCacheFileHeader);
+    SpeechDiskCacheIndexRecord record;
+    std::string voice;
+    std::string text;
+    while (fread(&record, sizeof(record), 1, pIndexFile) == 1) {
+        if (record.textSize > MAX_TEXT_SIZE || record.voiceSize > MAX_VOICE_SIZE) {
+            break;
+        }
+        voice.resize(record.voiceSize);
+        if (record.voiceSize > 0 && fread(voice.data(), 1, record.voiceSize, pIndexFile) != record.voiceSize) {
+            break;
+        }
+        text.resize(record.textSize);
+        if (record.textSize > 0 && fread(text.data(), 1, record.textSize, pIndexFile) != record.textSize) {
+            break;
+        }
+        if (computeRecordChecksum(record, voice, text) != record.checksum) {
+            break;
+        }
+
+        if (record.resampler > static_cast<uint32_t>(AudioResampler::Sinc)) {
+            break;
+        }
+        SpeechCacheKey key{voice, record.rate, record.sampleRate, (AudioResampler)record.resampler, text};
+        if (record.type == RECORD_TYPE_PUT) {
+            if (record.format == ma_format_unknown || record.format > ma_format_f32 || record.channels == 0 ||
+                record.dataOffset < sizeof(SpeechDiskCacheFileHeader) ||
+                record.dataOffset + record.dataSize > m_dataFileSize ||
+                record.dataSize !=
+                    record.frameCount * ma_get_bytes_per_frame((ma_format)record.format, record.channels)) {
+                break;
+            }
+            removeEntry(key);
+            addEntry(key, Entry{(ma_format)record.format, record.channels, record.sampleRate, record.frameCount,
+                                record.dataOffset, record.dataSize, m_nextSequence++});
+        } else if (record.type == RECORD_TYPE_EVICT) {
+            removeEntry(key);
+        } else {
+            break;
+        }
+        validIndexSize += sizeof(record) + record.voiceSize + record.textSize;
+    }
+    fclose(pIndexFile);
+
+    // A record torn by a crash is dropped, so new records are not appended after garbage
+    if (validIndexSize != indexFileSize) {
+        spdlog::warn("Dropping {} bytes of damaged records from the speech disk cache index",
+                     indexFileSize - validIndexSize);
+        std::filesystem::resize_file(m_indexPath, validIndexSize, error);
+        if (error) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SpeechDiskCache::compact() {
+    while (m_liveBytes > m_budgetInBytes && !m_entriesBySequence.empty()) {
+        const SpeechCacheKey oldestKey = m_entriesBySequence.begin()->second;
+        removeEntry(oldestKey);
+    }
+
+    auto source = MappedFile::open(m_dataPath);
+    if (source == nullptr) {
+        return false;
+    }
+    std::filesystem::path indexTempPath = m_indexPath;
+    indexTempPath += ".tmp";
+    std::filesystem::path dataTempPath = m_dataPath;
+    dataTempPath += ".tmp";
+    FILE* pIndexFile = openFile(indexTempPath, "wb");
+    FILE* pDataFile = openFile(dataTempPath, "wb");
+
+    const uint64_t storeId = generateStoreId();
+    bool isSuccessful = pIndexFile != nullptr && pDataFile != nullptr &&
+                        writeHeader(pIndexFile, INDEX_FILE_MAGIC, storeId) &&
+                        writeHeader(pDataFile, DATA_FILE_MAGIC, storeId);
+    uint64_t dataFileSize = sizeof(SpeechDiskCacheFileHeader);
+    std::unordered_map<SpeechCacheKey, uint64_t, SpeechCacheKeyHash> newOffsets;
+    for (auto& [sequence, key] : m_entriesBySequence) {
+        if (!isSuccessful) {
+            break;
+        }
+        Entry entry = m_entries.at(key);
+        const uint64_t dataOffset = alignDataOffset(dataFileSize);
+        isSuccessful = writePadding(pDataFile, dataFileSize, dataOffset) &&
+                       fwrite(source->data() + entry.dataOffset, 1, entry.dataSize, pDataFile) == entry.dataSize;
+        entry.dataOffset = dataOffset;
+        isSuccessful = isSuccessful && writeIndexRecord(pIndexFile, RECORD_TYPE_PUT, key, &entry);
+        newOffsets.emplace(key, dataOffset);
+        dataFileSize = dataOffset + entry.dataSize;
+    }
+    isSuccessful = isSuccessful && SyncFile(pDataFile) && SyncFile(pIndexFile);
+    if (pIndexFile != nullptr) {
+        fclose(pIndexFile);
+    }
+    if (pDataFile != nullptr) {
+        fclose(pDataFile);
+    }
+    // The old file cannot be replaced while it is mapped on Windows
+    source.reset();
+
+    std::error_code error;
+    if (isSuccessful) {
+        std::filesystem::rename(dataTempPath, m_dataPath, error);
+        if (!error) {
+            std::filesystem::rename(indexTempPath, m_indexPath, error);
+        }
+        isSuccessful = !error;
+    }
+    if (!isSuccessful) {
+        std::filesystem::remove(indexTempPath, error);
+        std::filesystem::remove(dataTempPath, error);
+        spdlog::error("Failed to compact the speech disk cache");
+        return false;
+    }
+
+    spdlog::info("Speech disk cache compacted from {} to {} bytes", m_dataFileSize, dataFileSize);
+    for (auto& [key, dataOffset] : newOffsets) {
+        m_entries.at(key).dataOffset = dataOffset;
+    }
+    m_storeId = storeId;
+    m_dataFileSize = dataFileSize;
+    return true;
+}
+
+bool SpeechDiskCache::create() {
+    m_storeId = generateStoreId();
+    FILE* pIndexFile = openFile(m_indexPath, "wb");
+    FILE* pDataFile = openFile(m_dataPath, "wb");
+    bool isSuccessful = pIndexFile != nullptr && pDataFile != nullptr &&
+                        writeHeader(pDataFile, DATA_FILE_MAGIC, m_storeId) && SyncFile(pDataFile) &&
+                        writeHeader(pIndexFile, INDEX_FILE_MAGIC, m_storeId) && SyncFile(pIndexFile);
+    if (pIndexFile != nullptr) {
+        fclose(pIndexFile);
+    }
+    if (pDataFile != nullptr) {
+        fclose(pDataFile);
+    }
+    m_dataFileSize = sizeof(SpeechDiskCacheFileHeader);
+    return isSuccessful;
+}
+
+bool SpeechDiskCache::openForAppend() {
+    m_pIndexFile = openFile(m_indexPath, "ab");
+    m_pDataFile = openFile(m_dataPath, "ab");
+    if (m_pIndexFile == nullptr || m_pDataFile == nullptr) {
+        return false;
+    }
+    m_mapping = MappedFile::open(m_dataPath);
+    return true;
+}
+
+void SpeechDiskCache::writeTasks(std::stop_token stopToken) {
+    std::deque<WriteTask> tasks;
+    while (true) {
+        {
+            std::unique_lock lock(m_tasksMutex);
+            m_tasksCondition.wait(lock, stopToken, [this] { return !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return;
+            }
+            tasks.swap(m_tasks);
+        }
+        if (!m_isWriteFailed && !writeBatch(tasks)) {
+            spdlog::error("Failed to write to the speech disk cache, new phrases are not saved anymore");
+            m_isWriteFailed = true;
+        }
+        {
+            std::lock_guard lock(m_entriesMutex);
+            for (const WriteTask& task : tasks) {
+                m_pendingKeys.erase(task.key);
+                m_pendingBytes -= task.entry.dataSize;
+                if (!m_isWriteFailed) {
+                    addEntry(task.key, task.entry);
+                }
+            }
+        }
+        tasks.clear();
+    }
+}
+
+bool SpeechDiskCache::writeBatch(const std::deque<WriteTask>& tasks) {
+    // Samples must reach the disk before the records that point to them, each file is synced once per batch
+    for (const WriteTask& task : tasks) {
+        if (!writePadding(m_pDataFile, m_writtenDataSize, task.entry.dataOffset) ||
+            fwrite(task.speech->pData, 1, task.entry.dataSize, m_pDataFile) != task.entry.dataSize) {
+            return false;
+        }
+        m_writtenDataSize = task.entry.dataOffset + task.entry.dataSize;
+    }
+    if (!SyncFile(m_pDataFile)) {
+        return false;
+    }
+    for (const WriteTask& task : tasks) {
+        for (const SpeechCacheKey& evictedKey : task.evictedKeys) {
+            if (!writeIndexRecord(m_pIndexFile, RECORD_TYPE_EVICT, evictedKey, nullptr)) {
+                return false;
+            }
+        }
+        if (!writeIndexRecord(m_pIndexFile, RECORD_TYPE_PUT, task.key, &task.entry)) {
+            return false;
+        }
+    }
+    return SyncFile(m_pIndexFile);
+}
+
+bool SpeechDiskCache::writeIndexRecord(FILE* pFile, uint32_t type, const SpeechCacheKey& key, const Entry* pEntry) {
+    SpeechDiskCacheIndexRecord record = {};
+    record.type = type;
+    record.textSize = static_cast<uint32_t>(key.text.size());
+    record.voiceSize = static_cast<uint32_t>(key.voice.size());
+    record.rate = key.rate;
+    record.sampleRate = key.sampleRate;
+    record.resampler = static_cast<uint32_t>(key.resampler);
+    if (pEntry != nullptr) {
+        record.format = pEntry->format;
+        record.channels = pEntry->channels;
+        record.frameCount = pEntry->frameCount;
+        record.dataOffset = pEntry->dataOffset;
+        record.dataSize = pEntry->dataSize;
+    }
+    record.checksum = computeRecordChecksum(record, key.voice, key.text);
+    return fwrite(&record, sizeof(record), 1, pFile) == 1 &&
+           fwrite(key.voice.data(), 1, key.voice.size(), pFile) == key.voice.size() &&
+           fwrite(key.text.data(), 1, key.text.size(), pFile) == key.text.size();
+}
+
+void SpeechDiskCache::addEntry(const SpeechCacheKey& key, const Entry& entry) {
+    m_entries.emplace(key, entry);
+    m_entriesBySequence.emplace(entry.sequence, key);
+    m_liveBytes += entry.dataSize;
+}
+
+void SpeechDiskCache::removeEntry(const SpeechCacheKey& key) {
+    auto iter = m_entries.find(key);
+    if (iter == m_entries.end()) {
+        return;
+    }
+    m_liveBytes -= iter->second.dataSize;
+    m_entriesBySequence.erase(iter->second.sequence);
+    m_entries.erase(iter);
+}
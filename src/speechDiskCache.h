@@ -0,0 +1,111 @@
+#pragma once
+
+#include "mappedFile.h"
+#include "speechCache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+inline constexpr size_t SPEECH_DISK_CACHE_DEFAULT_BUDGET_BYTES = 128 * 1024 * 1024;
+inline constexpr const char* SPEECH_DISK_CACHE_INDEX_FILE = "speechcache.idx";
+inline constexpr const char* SPEECH_DISK_CACHE_DATA_FILE = "speechcache.pcm";
+
+/*
+Persistent store of rendered speech made of two files: an append-only index of records and a PCM data file.
+The data file is memory-mapped, so cached speech is played straight from the mapping without copying.
+
+Writes are crash-safe: samples are synced to disk before the index record pointing to them, every index record
+carries a checksum, and a torn tail of the index is dropped on load. Both files carry the same store id,
+so a crash in the middle of compaction is detected and the store is started from scratch.
+
+Entries are keyed by the engine and voice name, so phrases never come back in a voice that took over the index.
+Evicting entries only appends records, the space is reclaimed by compaction when the store is opened.
+
+Inserted speech is written by a background thread, so the caller never waits for the disk. An entry can be found
+once its index record is synced, until then the memory cache above serves the phrase.
+*/
+class SpeechDiskCache {
+  public:
+    SpeechDiskCache() = default;
+    ~SpeechDiskCache();
+
+    SpeechDiskCache(const SpeechDiskCache&) = delete;
+    SpeechDiskCache& operator=(const SpeechDiskCache&) = delete;
+
+    bool open(const std::filesystem::path& indexPath, const std::filesystem::path& dataPath, size_t budgetInBytes);
+    void close();
+    RenderedSpeechPtr find(const SpeechCacheKey& key);
+    // Keeps the speech alive until it is written
+    void insert(const SpeechCacheKey& key, RenderedSpeechPtr speech);
+    size_t getEntryCount() const;
+    uint64_t getSizeInBytes() const;
+
+  private:
+    struct Entry {
+        ma_format format;
+        ma_uint32 channels;
+        ma_uint32 sampleRate;
+        ma_uint64 frameCount;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+        uint64_t sequence;
+    };
+
+    struct WriteTask {
+        SpeechCacheKey key;
+        RenderedSpeechPtr speech;
+        Entry entry;
+        // Entries evicted to make room for this one, their records are written before its own
+        std::vector<SpeechCacheKey> evictedKeys;
+    };
+
+    std::filesystem::path m_indexPath;
+    std::filesystem::path m_dataPath;
+    size_t m_budgetInBytes = 0;
+    uint64_t m_storeId = 0;
+    // Used by the writer thread only once it runs
+    FILE* m_pIndexFile = nullptr;
+    FILE* m_pDataFile = nullptr;
+    uint64_t m_writtenDataSize = 0;
+    // Includes the space reserved for speech which is not written yet
+    uint64_t m_dataFileSize = 0;
+    uint64_t m_nextSequence = 0;
+    // Set once the data file reached twice the budget, so it is reported only once
+    bool m_isDataFileFull = false;
+    std::atomic<bool> m_isWriteFailed = false;
+    // Guards the entries, which the writer thread publishes
+    mutable std::mutex m_entriesMutex;
+    std::unordered_map<SpeechCacheKey, Entry, SpeechCacheKeyHash> m_entries;
+    // Insertion order, the oldest entry is evicted first
+    std::map<uint64_t, SpeechCacheKey> m_entriesBySequence;
+    uint64_t m_liveBytes = 0;
+    // Queued for the writer, they count against the budget already
+    std::unordered_set<SpeechCacheKey, SpeechCacheKeyHash> m_pendingKeys;
+    uint64_t m_pendingBytes = 0;
+    std::shared_ptr<MappedFile> m_mapping;
+    std::mutex m_tasksMutex;
+    std::condition_variable_any m_tasksCondition;
+    std::deque<WriteTask> m_tasks;
+    std::jthread m_writer;
+
+    bool load();
+    bool compact();
+    bool create();
+    bool openForAppend();
+    void writeTasks(std::stop_token stopToken);
+    bool writeBatch(const std::deque<WriteTask>& tasks);
+    static bool writeIndexRecord(FILE* pFile, uint32_t type, const SpeechCacheKey& key, const Entry* pEntry);
+    void addEntry(const SpeechCacheKey& key, const Entry& entry);
+    void removeEntry(const SpeechCacheKey& key);
+};
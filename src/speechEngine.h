@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct SpeechVoice {
+    std::string name;
+    // Voices which are listed by the engine but cannot speak into memory
+    bool isSupported;
+};
+
+// PCM synthesized by an engine. The buffer is allocated with malloc and its ownership goes to the caller
+struct SynthesizedSpeech {
+    void* pData;
+    uint64_t bufferSize;
+    int channels;
+    int sampleRate;
+    int bitsPerSample;
+};
+
+/*
+Text-to-speech backend behind Speech. Calls are serialized by Speech, so implementations need no locking.
+Settings are applied right before synthesis and stay in effect until they are changed again.
+*/
+class ISpeechEngine {
+  public:
+    virtual ~ISpeechEngine() = default;
+
+    virtual const char* getName() const = 0;
+    virtual std::vector<SpeechVoice> getVoices() = 0;
+    virtual bool setVoice(uint64_t voiceIndex) = 0;
+    // Rate from -10 to 10, 0 is the voice default
+    virtual bool setRate(int64_t rate) = 0;
+    virtual std::optional<SynthesizedSpeech> synthesize(const char* text) = 0;
+};
@@ -0,0 +1,90 @@
+#include "speechWorker.h"
+
+#include "rtLogger.h"
+#include "speech.h"
+#include "traceRecorder.h"
+
+#include <spdlog/spdlog.h>
+
+SpeechWorker::SpeechWorker(CompletionCallback completionCallback)
+    : m_completionCallback(std::move(completionCallback)),
+      m_thread([this](std::stop_token stopToken) { run(stopToken); }) {
+}
+
+SpeechWorker::~SpeechWorker() {
+    cancelAll();
+    m_thread.request_stop();
+}
+
+uint64_t SpeechWorker::submit(std::string text) {
+    uint64_t jobId = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        jobId = m_nextJobId++;
+        m_jobs.push_back(SpeechJob{jobId, std::move(text), std::stop_source(), LatencyClock::now()});
+    }
+    m_condition.notify_one();
+    SIM_RT_DEBUG("Speech job {} submitted", jobId);
+    return jobId;
+}
+
+bool SpeechWorker::cancel(uint64_t jobId) {
+    std::lock_guard lock(m_mutex);
+    if (jobId == m_currentJobId && m_currentStopSource.stop_possible()) {
+        return m_currentStopSource.request_stop();
+    }
+    for (auto& job : m_jobs) {
+        if (job.id == jobId) {
+            // Pending jobs stay in the queue, so their cancellation is reported from the worker thread as well
+            return job.stopSource.request_stop();
+        }
+    }
+    return false;
+}
+
+void SpeechWorker::cancelAll() {
+    std::lock_guard lock(m_mutex);
+    if (m_currentStopSource.stop_possible()) {
+        m_currentStopSource.request_stop();
+    }
+    for (auto& job : m_jobs) {
+        job.stopSource.request_stop();
+    }
+}
+
+void SpeechWorker::run(std::stop_token stopToken) {
+    SIM_TRACE_THREAD_NAME("Speech worker");
+    spdlog::debug("Speech worker started");
+    while (true) {
+        SpeechJob job;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_condition.wait(lock, stopToken, [this] { return !m_jobs.empty(); })) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_currentJobId = job.id;
+            m_currentStopSource = job.stopSource;
+        }
+
+        SpeechJobResult result{job.id, std::move(job.text), false, false};
+        if (!job.stopSource.stop_requested()) {
+            result.isSuccessful =
+                Speech::GetInstance().speak(result.text.c_str(), job.stopSource.get_token(), job.requestTime);
+        }
+        result.isCancelled = job.stopSource.stop_requested();
+        {
+            std::lock_guard lock(m_mutex);
+            m_currentJobId = 0;
+            m_currentStopSource = std::stop_source(std::nostopstate);
+        }
+
+        SIM_RT_DEBUG("Speech job {} finished, successful: {}, cancelled: {}", result.jobId, result.isSuccessful,
+                     result.isCancelled);
+        if (m_completionCallback) {
+            m_completionCallback(result);
+        }
+    }
+    spdlog::debug("Speech worker stopped");
+}
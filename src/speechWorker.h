@@ -0,0 +1,60 @@
+#pragma once
+
+#include "latencyTracker.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+struct SpeechJobResult {
+    uint64_t jobId;
+    std::string text;
+    bool isSuccessful;
+    bool isCancelled;
+};
+
+// Runs speech synthesis jobs one by one on a dedicated thread, so the caller never waits for SAPI
+class SpeechWorker {
+  public:
+    // The callback is invoked on the worker thread after every job, including cancelled ones
+    using CompletionCallback = std::function<void(const SpeechJobResult&)>;
+
+    explicit SpeechWorker(CompletionCallback completionCallback);
+    ~SpeechWorker();
+
+    SpeechWorker(const SpeechWorker&) = delete;
+    SpeechWorker& operator=(const SpeechWorker&) = delete;
+    SpeechWorker(SpeechWorker&&) = delete;
+    SpeechWorker& operator=(SpeechWorker&&) = delete;
+
+    uint64_t submit(std::string text);
+    // Removes a pending job or asks the running one to stop before its next chunk
+    bool cancel(uint64_t jobId);
+    void cancelAll();
+
+  private:
+    struct SpeechJob {
+        uint64_t id;
+        std::string text;
+        std::stop_source stopSource;
+        // Latencies of the job are measured from here, which is right after the user asked for it
+        LatencyClock::time_point requestTime;
+    };
+
+    CompletionCallback m_completionCallback;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::deque<SpeechJob> m_jobs;
+    uint64_t m_nextJobId = 1;
+    uint64_t m_currentJobId = 0;
+    std::stop_source m_currentStopSource{std::nostopstate};
+    // Declared last so the thread is joined before the members it uses are destroyed
+    std::jthread m_thread;
+
+    void run(std::stop_token stopToken);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+/*
+Fixed-size lock-free ring buffer for exactly one producer thread and one consumer thread.
+Neither side ever allocates or blocks, so the consumer side is safe to use from the audio device callback.
+The capacity is rounded up to a power of two.
+*/
+template <class T> class SpscRingBuffer {
+  public:
+    explicit SpscRingBuffer(size_t capacity)
+        : m_capacity(std::bit_ceil(capacity)), m_mask(m_capacity - 1), m_data(std::make_unique<T[]>(m_capacity)) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Producer side
+    size_t availableToWrite() const {
+        return m_capacity -
+               (m_writeIndex.load(std::memory_order_relaxed) - m_readIndex.load(std::memory_order_acquire));
+    }
+
+    size_t write(const T* pData, size_t count) {
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        count = std::min(count, m_capacity - (writeIndex - m_readIndex.load(std::memory_order_acquire)));
+        const size_t offset = writeIndex & m_mask;
+        const size_t firstPart = std::min(count, m_capacity - offset);
+        std::copy_n(pData, firstPart, &m_data[offset]);
+        std::copy_n(pData + firstPart, count - firstPart, &m_data[0]);
+        m_writeIndex.store(writeIndex + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side
+    size_t availableToRead() const {
+        return m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_relaxed);
+    }
+
+    size_t read(T* pData, size_t count) {
+        const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        count = std::min(count, m_writeIndex.load(std::memory_order_acquire) - readIndex);
+        const size_t offset = readIndex & m_mask;
+        const size_t firstPart = std::min(count, m_capacity - offset);
+        std::copy_n(&m_data[offset], firstPart, pData);
+        std::copy_n(&m_data[0], count - firstPart, pData + firstPart);
+        m_readIndex.store(readIndex + count, std::memory_order_release);
+        return count;
+    }
+
+  private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_data;
+    // Indices grow monotonically and are wrapped with the mask on access
+    alignas(64) std::atomic<size_t> m_writeIndex = 0;
+    alignas(64) std::atomic<size_t> m_readIndex = 0;
+};
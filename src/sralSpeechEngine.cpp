@@ -0,0 +1,98 @@
+#include "sralSpeechEngine.h"
+
+#include "unsupportedVoicesFilter.h"
+
+#include <SRAL.h>
+#include <cstdlib>
+#include <mutex>
+#include <spdlog/spdlog.h>
+
+// SRAL drives a single global SAPI engine, so all instances share it and take turns with it
+static std::mutex s_sralMutex;
+static size_t s_instanceCount = 0;
+// Settings SRAL currently uses, an instance reapplies its own ones when another instance has changed them
+static std::optional<uint64_t> s_appliedVoiceIndex;
+static std::optional<int64_t> s_appliedRate;
+
+SralSpeechEngine::SralSpeechEngine() {
+    std::lock_guard lock(s_sralMutex);
+    if (s_instanceCount++ == 0 && !SRAL_IsInitialized()) {
+        spdlog::debug("SRAL instance initializing");
+        SRAL_Initialize(SRAL_ENGINE_NVDA | SRAL_ENGINE_JAWS | SRAL_ENGINE_UIA);
+        spdlog::debug("SRAL initialized");
+    }
+}
+
+SralSpeechEngine::~SralSpeechEngine() {
+    std::lock_guard lock(s_sralMutex);
+    if (--s_instanceCount == 0 && SRAL_IsInitialized()) {
+        spdlog::debug("Uninitializing SRAL");
+        SRAL_Uninitialize();
+        s_appliedVoiceIndex.reset();
+        s_appliedRate.reset();
+        spdlog::debug("SRAL uninitialized");
+    }
+}
+
+std::vector<SpeechVoice> SralSpeechEngine::getVoices() {
+    std::lock_guard lock(s_sralMutex);
+    int voiceCount = 0;
+    if (!SRAL_GetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_COUNT, &voiceCount)) {
+        spdlog::error("Failed to get voice count from SRAL.");
+        return {};
+    }
+    if (voiceCount <= 0) {
+        return {};
+    }
+    std::vector<SRAL_VoiceInfo> voiceInfos(voiceCount);
+    if (!SRAL_GetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_PROPERTIES, voiceInfos.data())) {
+        spdlog::error("Failed to get voice properties from SRAL.");
+        return {};
+    }
+    std::vector<SpeechVoice> voices;
+    voices.reserve(voiceCount);
+    for (const auto& voiceInfo : voiceInfos) {
+        voices.push_back({voiceInfo.name, CheckVoiceIsSupported(voiceInfo)});
+    }
+    return voices;
+}
+
+bool SralSpeechEngine::setVoice(uint64_t voiceIndex) {
+    std::lock_guard lock(s_sralMutex);
+    if (!SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_INDEX, &voiceIndex)) {
+        return false;
+    }
+    m_voiceIndex = voiceIndex;
+    s_appliedVoiceIndex = voiceIndex;
+    return true;
+}
+
+bool SralSpeechEngine::setRate(int64_t rate) {
+    std::lock_guard lock(s_sralMutex);
+    if (!SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_SPEECH_RATE, &rate)) {
+        return false;
+    }
+    m_rate = rate;
+    s_appliedRate = rate;
+    return true;
+}
+
+std::optional<SynthesizedSpeech> SralSpeechEngine::synthesize(const char* text) {
+    std::lock_guard lock(s_sralMutex);
+    if (m_voiceIndex.has_value() && s_appliedVoiceIndex != m_voiceIndex) {
+        SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_VOICE_INDEX, &*m_voiceIndex);
+        s_appliedVoiceIndex = m_voiceIndex;
+    }
+    if (m_rate.has_value() && s_appliedRate != m_rate) {
+        SRAL_SetEngineParameter(SRAL_ENGINE_SAPI, SRAL_PARAM_SPEECH_RATE, &*m_rate);
+        s_appliedRate = m_rate;
+    }
+    SynthesizedSpeech speech{};
+    speech.pData = SRAL_SpeakToMemoryEx(SRAL_ENGINE_SAPI, text, &speech.bufferSize, &speech.channels,
+                                        &speech.sampleRate, &speech.bitsPerSample);
+    if (speech.pData == nullptr) {
+        spdlog::error("SRAL_SpeakToMemoryEx returned nullptr");
+        return std::nullopt;
+    }
+    return speech;
+}
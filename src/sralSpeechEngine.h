@@ -0,0 +1,23 @@
+#pragma once
+
+#include "speechEngine.h"
+
+/*
+SAPI voices through SRAL, speaking into memory instead of to the default device.
+Instances may live on different threads, but they share one SRAL engine and synthesize one at a time.
+*/
+class SralSpeechEngine : public ISpeechEngine {
+  public:
+    SralSpeechEngine();
+    ~SralSpeechEngine() override;
+
+    const char* getName() const override { return "sapi"; }
+    std::vector<SpeechVoice> getVoices() override;
+    bool setVoice(uint64_t voiceIndex) override;
+    bool setRate(int64_t rate) override;
+    std::optional<SynthesizedSpeech> synthesize(const char* text) override;
+
+  private:
+    std::optional<uint64_t> m_voiceIndex;
+    std::optional<int64_t> m_rate;
+};
@@ -0,0 +1,120 @@
+#include "syntheticSpeechEngine.h"
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <numbers>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+static constexpr double SYNTHETIC_VOICE_FREQUENCIES[] = {220.0, 440.0, 880.0};
+// Roughly the pace of a SAPI voice at the default rate
+static constexpr double SYNTHETIC_SECONDS_PER_CHARACTER = 0.06;
+static constexpr double SYNTHETIC_AMPLITUDE = 0.5;
+
+static void writeSample(double sample, int bitsPerSample, unsigned char* pOutput) {
+    switch (bitsPerSample) {
+        case 8:
+            *pOutput = (unsigned char)std::lround(128.0 + sample * 127.0);
+            break;
+        case 16: {
+            const auto value = (int16_t)std::lround(sample * 32767.0);
+            std::memcpy(pOutput, &value, sizeof(value));
+            break;
+        }
+        case 24: {
+            const auto value = (int32_t)std::lround(sample * 8388607.0);
+            pOutput[0] = (unsigned char)(value & 0xFF);
+            pOutput[1] = (unsigned char)((value >> 8) & 0xFF);
+            pOutput[2] = (unsigned char)((value >> 16) & 0xFF);
+            break;
+        }
+        case 32: {
+            const auto value = (int32_t)std::lround(sample * 2147483647.0);
+            std::memcpy(pOutput, &value, sizeof(value));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+SyntheticSpeechEngine::SyntheticSpeechEngine(const SyntheticSpeechConfig& config) : m_config(config) {
+    spdlog::debug("Synthetic speech engine: {}, {} Hz, {} bits, {} channels, {} ms render latency",
+                  config.waveform == SyntheticWaveform::Tone ? "tone" : "noise", config.sampleRate,
+                  config.bitsPerSample, config.channels, config.renderLatency.count());
+}
+
+std::vector<SpeechVoice> SyntheticSpeechEngine::getVoices() {
+    std::vector<SpeechVoice> voices;
+    for (double frequency : SYNTHETIC_VOICE_FREQUENCIES) {
+        voices.push_back({std::format("Synthetic {:.0f} Hz", frequency), true});
+    }
+    return voices;
+}
+
+bool SyntheticSpeechEngine::setVoice(uint64_t voiceIndex) {
+    if (voiceIndex >= std::size(SYNTHETIC_VOICE_FREQUENCIES)) {
+        return false;
+    }
+    m_voiceIndex = voiceIndex;
+    return true;
+}
+
+bool SyntheticSpeechEngine::setRate(int64_t rate) {
+    if (rate < -10 || rate > 10) {
+        return false;
+    }
+    m_rate = rate;
+    return true;
+}
+
+std::optional<SynthesizedSpeech> SyntheticSpeechEngine::synthesize(const char* text) {
+    const int bytesPerSample = m_config.bitsPerSample / 8;
+    if (m_config.sampleRate <= 0 || m_config.channels <= 0 || bytesPerSample < 1 || bytesPerSample > 4) {
+        spdlog::error("Invalid synthetic speech format: {} Hz, {} bits, {} channels", m_config.sampleRate,
+                      m_config.bitsPerSample, m_config.channels);
+        return std::nullopt;
+    }
+    std::this_thread::sleep_for(m_config.renderLatency);
+
+    // Like SAPI rates, every 10 steps speed speech up or slow it down about two times
+    const size_t textLength = std::max<size_t>(std::strlen(text), 1);
+    const double seconds = textLength * SYNTHETIC_SECONDS_PER_CHARACTER * std::exp2(-(double)m_rate / 10.0);
+    const auto frameCount = (uint64_t)(seconds * m_config.sampleRate);
+    const uint64_t bytesPerFrame = (uint64_t)bytesPerSample * m_config.channels;
+    SynthesizedSpeech speech{nullptr, frameCount * bytesPerFrame, m_config.channels, m_config.sampleRate,
+                             m_config.bitsPerSample};
+    auto* pOutput = (unsigned char*)malloc(speech.bufferSize);
+    if (pOutput == nullptr) {
+        spdlog::error("Failed to allocate {} bytes of synthetic speech", speech.bufferSize);
+        return std::nullopt;
+    }
+
+    // Noise is seeded from everything that affects the output, so it repeats exactly for the same input
+    uint64_t state = Fnv1a64(text, std::strlen(text));
+    state = Fnv1a64(&m_voiceIndex, sizeof(m_voiceIndex), state);
+    state = Fnv1a64(&m_rate, sizeof(m_rate), state) | 1;
+    const double step = 2.0 * std::numbers::pi * SYNTHETIC_VOICE_FREQUENCIES[m_voiceIndex] / m_config.sampleRate;
+    for (uint64_t frame = 0; frame < frameCount; ++frame) {
+        double sample = 0.0;
+        if (m_config.waveform == SyntheticWaveform::Tone) {
+            sample = SYNTHETIC_AMPLITUDE * std::sin(step * (double)frame);
+        } else {
+            // xorshift64
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            sample = SYNTHETIC_AMPLITUDE * ((double)(state >> 11) / (double)(1ull << 52) - 1.0);
+        }
+        for (int channel = 0; channel < m_config.channels; ++channel) {
+            writeSample(sample, m_config.bitsPerSample, pOutput + frame * bytesPerFrame + channel * bytesPerSample);
+        }
+    }
+    speech.pData = pOutput;
+    return speech;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "speechEngine.h"
+
+#include <chrono>
+#include <cstdint>
+
+enum class SyntheticWaveform {
+    Tone,
+    Noise,
+};
+
+struct SyntheticSpeechConfig {
+    SyntheticWaveform waveform = SyntheticWaveform::Tone;
+    // Defaults match the most common SAPI voices
+    int sampleRate = 22050;
+    int bitsPerSample = 16;
+    int channels = 1;
+    // Time every synthesis takes before returning, stands in for the work of a real engine
+    std::chrono::milliseconds renderLatency{0};
+};
+
+/*
+Engine which renders a tone or noise instead of speech, so the playback pipeline can be measured and tested
+without SAPI. The output depends only on the text and the settings: the same input always gives the same samples.
+*/
+class SyntheticSpeechEngine : public ISpeechEngine {
+  public:
+    explicit SyntheticSpeechEngine(const SyntheticSpeechConfig& config);
+
+    const char* getName() const override { return "synthetic"; }
+    // Every voice plays its own tone frequency
+    std::vector<SpeechVoice> getVoices() override;
+    bool setVoice(uint64_t voiceIndex) override;
+    bool setRate(int64_t rate) override;
+    std::optional<SynthesizedSpeech> synthesize(const char* text) override;
+
+  private:
+    SyntheticSpeechConfig m_config;
+    uint64_t m_voiceIndex = 0;
+    int64_t m_rate = 0;
+};
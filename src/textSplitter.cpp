@@ -0,0 +1,58 @@
+#include "textSplitter.h"
+
+static constexpr size_t MIN_CHUNK_LENGTH = 16;
+static constexpr size_t CLAUSE_SPLIT_LENGTH = 80;
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isSentenceEnd(char c) {
+    return c == '.' || c == '!' || c == '?';
+}
+
+static bool isClauseEnd(char c) {
+    return c == ',' || c == ';' || c == ':';
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::vector<std::string> SplitTextIntoChunks(std::string_view text) {
+    std::vector<std::string> chunks;
+    size_t chunkStart = 0;
+    auto flushChunk = [&](size_t chunkEnd) {
+        auto chunk = trim(text.substr(chunkStart, chunkEnd - chunkStart));
+        chunkStart = chunkEnd;
+        if (chunk.empty()) {
+            return;
+        }
+        if (!chunks.empty() && chunks.back().size() < MIN_CHUNK_LENGTH) {
+            chunks.back().append(" ").append(chunk);
+            return;
+        }
+        chunks.emplace_back(chunk);
+    };
+
+    // Punctuation is always ASCII, so splitting by bytes never breaks a UTF-8 sequence
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        const bool isFollowedBySpace = i + 1 == text.size() || isSpace(text[i + 1]);
+        if (c == '\n') {
+            flushChunk(i + 1);
+        } else if (isFollowedBySpace && isSentenceEnd(c)) {
+            flushChunk(i + 1);
+        } else if (isFollowedBySpace && isClauseEnd(c) && i + 1 - chunkStart >= CLAUSE_SPLIT_LENGTH) {
+            flushChunk(i + 1);
+        }
+    }
+    flushChunk(text.size());
+    return chunks;
+}
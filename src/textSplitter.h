@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits text into sentence or clause sized chunks which can be synthesized one by one.
+// Chunks shorter than a few words are merged with the following one to keep the prosody natural.
+std::vector<std::string> SplitTextIntoChunks(std::string_view text);
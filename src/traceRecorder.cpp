@@ -0,0 +1,143 @@
+#include "traceRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+
+// Plain values, so no thread registers a thread_local destructor, which could allocate on the audio threads
+static thread_local TraceRecorder::ThreadBuffer* t_pThreadBuffer = nullptr;
+static thread_local bool t_isThreadBufferBound = false;
+
+TraceRecorder::~TraceRecorder() {
+    if (m_isRecording) {
+        m_isRecording = false;
+        write();
+    }
+}
+
+void TraceRecorder::start(const std::filesystem::path& path) {
+    std::lock_guard lock(m_buffersMutex);
+    m_path = path;
+    m_startTime = std::chrono::steady_clock::now();
+    m_isRecording = true;
+    spdlog::debug("Recording a trace to {}", path.string());
+}
+
+void TraceRecorder::record(const char* name, std::chrono::steady_clock::time_point startTime,
+                           std::chrono::steady_clock::time_point endTime) {
+    ThreadBuffer* pBuffer = getThreadBuffer();
+    if (pBuffer == nullptr) {
+        return;
+    }
+    const size_t eventCount = pBuffer->eventCount.load(std::memory_order_relaxed);
+    if (eventCount == TRACE_EVENTS_PER_THREAD) {
+        pBuffer->droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pBuffer->events[eventCount] = Event{name, startTime, endTime};
+    pBuffer->eventCount.store(eventCount + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const char* name) {
+    if (!isRecording()) {
+        return;
+    }
+    ThreadBuffer* pBuffer = getThreadBuffer();
+    if (pBuffer != nullptr && pBuffer->name.load(std::memory_order_relaxed) != name) {
+        pBuffer->name.store(name, std::memory_order_release);
+    }
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::acquireThreadBuffer(const char* name) {
+    if (!isRecording()) {
+        return nullptr;
+    }
+    std::lock_guard lock(m_buffersMutex);
+    auto iter = std::ranges::find_if(m_releasedBuffers, [&](const ThreadBuffer* pBuffer) {
+        return std::string_view(pBuffer->name.load(std::memory_order_relaxed)) == name;
+    });
+    if (iter != m_releasedBuffers.end()) {
+        ThreadBuffer* pBuffer = *iter;
+        m_releasedBuffers.erase(iter);
+        return pBuffer;
+    }
+    ThreadBuffer* pBuffer = addThreadBuffer();
+    pBuffer->name.store(name, std::memory_order_release);
+    return pBuffer;
+}
+
+void TraceRecorder::releaseThreadBuffer(ThreadBuffer* pBuffer) {
+    if (pBuffer == nullptr) {
+        return;
+    }
+    // Its events stay until the trace is written
+    std::lock_guard lock(m_buffersMutex);
+    m_releasedBuffers.push_back(pBuffer);
+}
+
+void TraceRecorder::bindThreadBuffer(ThreadBuffer* pBuffer) {
+    t_pThreadBuffer = pBuffer;
+    t_isThreadBufferBound = true;
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer() {
+    if (t_pThreadBuffer == nullptr && !t_isThreadBufferBound) {
+        std::lock_guard lock(m_buffersMutex);
+        t_pThreadBuffer = addThreadBuffer();
+    }
+    return t_pThreadBuffer;
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::addThreadBuffer() {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->threadId = m_buffers.size() + 1;
+    m_buffers.push_back(std::move(buffer));
+    return m_buffers.back().get();
+}
+
+void TraceRecorder::write() {
+    std::lock_guard lock(m_buffersMutex);
+    FILE* file = nullptr;
+#ifdef _WIN32
+    _wfopen_s(&file, m_path.c_str(), L"wb");
+#else
+    file = std::fopen(m_path.c_str(), "wb");
+#endif
+    if (file == nullptr) {
+        spdlog::error("Failed to open the trace file {}", m_path.string());
+        return;
+    }
+    auto toMicroseconds = [&](std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - m_startTime).count();
+    };
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", file);
+    bool isFirstEvent = true;
+    auto writeEvent = [&](const std::string& event) {
+        std::fputs(isFirstEvent ? "  " : ",\n  ", file);
+        std::fputs(event.c_str(), file);
+        isFirstEvent = false;
+    };
+    size_t droppedCount = 0;
+    for (const auto& buffer : m_buffers) {
+        const char* threadName = buffer->name.load(std::memory_order_acquire);
+        writeEvent(std::format(R"({{"name": "thread_name", "ph": "M", "pid": 1, "tid": {}, "args": {{"name": "{}"}}}})",
+                               buffer->threadId,
+                               threadName != nullptr ? threadName : std::format("Thread {}", buffer->threadId)));
+        const size_t eventCount = buffer->eventCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < eventCount; ++i) {
+            const Event& event = buffer->events[i];
+            writeEvent(std::format(R"({{"name": "{}", "ph": "X", "pid": 1, "tid": {}, "ts": {:.3f}, "dur": {:.3f}}})",
+                                   event.name, buffer->threadId, toMicroseconds(event.startTime),
+                                   toMicroseconds(event.endTime) - toMicroseconds(event.startTime)));
+        }
+        droppedCount += buffer->droppedCount.load(std::memory_order_relaxed);
+    }
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+    if (droppedCount > 0) {
+        spdlog::warn("{} trace events were dropped because their thread buffers were full", droppedCount);
+    }
+}
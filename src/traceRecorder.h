@@ -0,0 +1,110 @@
+#pragma once
+
+#include "singleton.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Events a thread can record, later ones are dropped. The audio callback fills this in about ten minutes
+inline constexpr size_t TRACE_EVENTS_PER_THREAD = 64 * 1024;
+
+/*
+Records timed zones of every thread and writes them in the Chrome Trace Event format, which Perfetto and
+chrome://tracing open with a track per thread. Each thread appends to its own preallocated buffer without locking,
+so zones are cheap enough for the audio device callback. The first zone of a thread allocates its buffer, except on
+threads which are bound to a buffer acquired for them in advance, such as the audio device callbacks.
+*/
+class TraceRecorder {
+  public:
+    struct ThreadBuffer;
+
+    ~TraceRecorder();
+
+    // The trace is written to the file when the program exits
+    void start(const std::filesystem::path& path);
+    bool isRecording() const { return m_isRecording.load(std::memory_order_relaxed); }
+    void record(const char* name, std::chrono::steady_clock::time_point startTime,
+                std::chrono::steady_clock::time_point endTime);
+    // Names the track of the calling thread, the name must be a string literal
+    void setThreadName(const char* name);
+    // Buffer for a thread which is started by someone else and must not allocate, nullptr when not recording.
+    // A released buffer is reused by the next thread acquired under the same name, so they share a track
+    ThreadBuffer* acquireThreadBuffer(const char* name);
+    // The thread bound to the buffer must have exited
+    void releaseThreadBuffer(ThreadBuffer* pBuffer);
+    // The calling thread records into this buffer from now on, or records nothing if it is nullptr
+    void bindThreadBuffer(ThreadBuffer* pBuffer);
+
+  private:
+    struct Event {
+        const char* name;
+        std::chrono::steady_clock::time_point startTime;
+        std::chrono::steady_clock::time_point endTime;
+    };
+
+  public:
+    // Only passed around outside of the recorder
+    struct ThreadBuffer {
+        size_t threadId;
+        std::atomic<const char*> name = nullptr;
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(TRACE_EVENTS_PER_THREAD);
+        // Written by the owning thread only, published with release so the writer sees complete events
+        std::atomic<size_t> eventCount = 0;
+        std::atomic<size_t> droppedCount = 0;
+    };
+
+  private:
+    std::atomic<bool> m_isRecording = false;
+    std::filesystem::path m_path;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<ThreadBuffer*> m_releasedBuffers;
+
+    // Nullptr for threads bound to no buffer
+    ThreadBuffer* getThreadBuffer();
+    ThreadBuffer* addThreadBuffer();
+    void write();
+};
+
+#define g_TraceRecorder CSingleton<TraceRecorder>::GetInstance()
+
+class TraceZone {
+  public:
+    explicit TraceZone(const char* name) : m_name(name), m_isRecording(g_TraceRecorder.isRecording()) {
+        if (m_isRecording) {
+            m_startTime = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceZone() {
+        if (m_isRecording) {
+            g_TraceRecorder.record(m_name, m_startTime, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+  private:
+    const char* m_name;
+    bool m_isRecording;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+// Zones only exist in builds configured with SIM_ENABLE_TRACING, otherwise they compile to nothing
+#ifdef SIM_ENABLE_TRACING
+#define SIM_TRACE_CONCAT_IMPL(first, second) first##second
+#define SIM_TRACE_CONCAT(first, second) SIM_TRACE_CONCAT_IMPL(first, second)
+#define SIM_TRACE_ZONE(name) TraceZone SIM_TRACE_CONCAT(traceZone, __LINE__)(name)
+#define SIM_TRACE_THREAD_NAME(name) g_TraceRecorder.setThreadName(name)
+#define SIM_TRACE_BIND_THREAD_BUFFER(pBuffer) g_TraceRecorder.bindThreadBuffer(pBuffer)
+#else
+#define SIM_TRACE_ZONE(name) ((void)0)
+#define SIM_TRACE_THREAD_NAME(name) ((void)0)
+#define SIM_TRACE_BIND_THREAD_BUFFER(pBuffer) ((void)(pBuffer))
+#endif
@@ -1,11 +1,13 @@
 #include "ui.h"
 
 #include "audio.h"
+#include "cliOptions.h"
 #include "historyStorage.h"
-#include "loggerSetup.h"
+#include "latencyTracker.h"
+#include "rtLogger.h"
 #include "speech.h"
+#include "traceRecorder.h"
 
-#include <CLI/CLI.hpp>
 #include <cstring>
 #include <spdlog/spdlog.h>
 #include <string>
@@ -14,6 +16,9 @@
 
 static std::string PROGRAM_TITLE = std::format("SIM {}", SIM_FULL_VERSION);
 
+wxDEFINE_EVENT(wxEVT_SPEECH_COMPLETED, wxThreadEvent);
+wxDEFINE_EVENT(wxEVT_SPEECH_FAILED, wxThreadEvent);
+
 MainFrame::MainFrame(const wxString& title, int cliVoiceIndex, std::string cliVoiceName, int cliOutputDeviceIndex,
                      std::string helpText)
     : wxFrame(nullptr, wxID_ANY, title) {
@@ -31,6 +36,9 @@ MainFrame::MainFrame(const wxString& title, int cliVoiceIndex, std::string cliVo
     m_messageField = new wxTextCtrl(m_panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
                                     wxTE_DONTWRAP | wxTE_PROCESS_ENTER);
 
+    auto* historyMatchesListLabel = new wxStaticText(m_panel, wxID_ANY, "History matches");
+    m_historyMatchesList = new wxListBox(m_panel, wxID_ANY);
+
     auto* voicesListLabel = new wxStaticText(m_panel, wxID_ANY, "Voice");
     m_voicesList = new wxListBox(m_panel, wxID_ANY);
 
@@ -43,6 +51,7 @@ MainFrame::MainFrame(const wxString& title, int cliVoiceIndex, std::string cliVo
     auto* volumeSliderLabel = new wxStaticText(m_panel, wxID_ANY, "Output volume");
     m_volumeSlider = new wxSlider(m_panel, wxID_ANY, 100, 0, 100);
 
+    m_refreshDevicesButton = new wxButton(m_panel, wxID_ANY, "Refresh Devices");
     m_helpButton = new wxButton(m_panel, wxID_ANY, "Command Line Help");
 
     auto* voicesListSizer = new wxBoxSizer(wxVERTICAL);
@@ -70,8 +79,14 @@ MainFrame::MainFrame(const wxString& title, int cliVoiceIndex, std::string cliVo
     messageFieldSizer->Add(m_messageField);
     mainSizer->Add(messageFieldSizer);
 
+    auto* historyMatchesListSizer = new wxBoxSizer(wxVERTICAL);
+    historyMatchesListSizer->Add(historyMatchesListLabel);
+    historyMatchesListSizer->Add(m_historyMatchesList);
+    mainSizer->Add(historyMatchesListSizer);
+
     mainSizer->Add(selectionsSizer);
     mainSizer->Add(settingsSizer);
+    mainSizer->Add(m_refreshDevicesButton);
     mainSizer->Add(m_helpButton);
 
     m_messageField->SetFocus();
@@ -81,12 +96,24 @@ MainFrame::MainFrame(const wxString& title, int cliVoiceIndex, std::string cliVo
     m_volumeSlider->Bind(wxEVT_SLIDER, &MainFrame::OnVolumeSliderChange, this);
     m_messageField->Bind(wxEVT_TEXT_ENTER, &MainFrame::OnEnterPress, this);
     m_messageField->Bind(wxEVT_KEY_DOWN, &MainFrame::OnMessageFieldKeyDown, this);
+    m_messageField->Bind(wxEVT_TEXT, &MainFrame::OnMessageFieldTextChange, this);
+    m_historyMatchesList->Bind(wxEVT_LISTBOX, &MainFrame::OnHistoryMatchSelect, this);
     m_voicesList->Bind(wxEVT_LISTBOX, &MainFrame::OnVoiceChange, this);
     m_outputDevicesList->Bind(wxEVT_LISTBOX, &MainFrame::OnOutputDeviceChange, this);
+    m_refreshDevicesButton->Bind(wxEVT_BUTTON, &MainFrame::OnRefresh, this);
     m_helpButton->Bind(wxEVT_BUTTON, &MainFrame::OnHelpButton, this);
+    this->Bind(wxEVT_SPEECH_COMPLETED, &MainFrame::OnSpeechCompleted, this);
+    this->Bind(wxEVT_SPEECH_FAILED, &MainFrame::OnSpeechFailed, this);
 
     populateVoicesList();
     populateDevicesList();
+
+    m_speechWorker = std::make_unique<SpeechWorker>([this](const SpeechJobResult& result) {
+        auto* event = new wxThreadEvent(result.isSuccessful || result.isCancelled ? wxEVT_SPEECH_COMPLETED
+                                                                                  : wxEVT_SPEECH_FAILED);
+        event->SetPayload(result);
+        wxQueueEvent(this, event);
+    });
 }
 
 void MainFrame::populateVoicesList() {
@@ -97,20 +124,10 @@ void MainFrame::populateVoicesList() {
         spdlog::warn("No voices available, voice selection is disabled");
         return;
     }
-    size_t voiceCounter = 0;
-    bool isVoiceFoundByName = false;
     for (const auto& voiceName : voices) {
         m_voicesList->AppendString(wxString::FromUTF8(voiceName));
-        if (!isVoiceFoundByName && voiceName == m_cliVoiceName) {
-            m_cliVoiceIndex = voiceCounter;
-            isVoiceFoundByName = true;
-        }
-        voiceCounter++;
-    }
-    if (m_cliVoiceIndex < 0 || static_cast<size_t>(m_cliVoiceIndex) >= voices.size()) {
-        spdlog::warn("Voice index {} is out of range. Falling back to 0.", m_cliVoiceIndex);
-        m_cliVoiceIndex = 0;
     }
+    m_cliVoiceIndex = static_cast<int>(ResolveVoiceIndex(voices, m_cliVoiceName, m_cliVoiceIndex));
     m_voicesList->SetSelection(m_cliVoiceIndex);
     Speech::GetInstance().setVoice(static_cast<uint64_t>(m_cliVoiceIndex));
 }
@@ -148,14 +165,23 @@ void MainFrame::OnEnterPress(wxCommandEvent& event) {
     }
     wxString messageText = m_messageField->GetValue();
     auto text = std::string(messageText.utf8_str());
-    if (!Speech::GetInstance().speak(text.c_str())) {
-        wxMessageBox("This voice either does not work with the program or crashes it. Please select another voice.",
-                     "Error! The selected SAPI voice is not supported.", 5L, m_panel);
-    }
+    m_speechWorker->submit(text);
     g_HistoryStorage.push(text);
     m_messageField->Clear();
 }
 
+void MainFrame::OnSpeechCompleted(wxThreadEvent& event) {
+    auto result = event.GetPayload<SpeechJobResult>();
+    if (result.isCancelled) {
+        SIM_RT_DEBUG("Speech job {} was cancelled", result.jobId);
+    }
+}
+
+void MainFrame::OnSpeechFailed(wxThreadEvent& event) {
+    wxMessageBox("This voice either does not work with the program or crashes it. Please select another voice.",
+                 "Error! The selected SAPI voice is not supported.", 5L, m_panel);
+}
+
 void MainFrame::OnMessageFieldKeyDown(wxKeyEvent& event) {
     auto text = std::string(m_messageField->GetValue().utf8_str());
     switch (event.GetKeyCode()) {
@@ -171,6 +197,22 @@ void MainFrame::OnMessageFieldKeyDown(wxKeyEvent& event) {
     event.Skip();
 }
 
+void MainFrame::OnMessageFieldTextChange(wxCommandEvent& event) {
+    m_historyMatchesList->Clear();
+    for (const auto& match : g_HistoryStorage.search(std::string(m_messageField->GetValue().utf8_str()))) {
+        m_historyMatchesList->AppendString(wxString::FromUTF8(match));
+    }
+}
+
+void MainFrame::OnHistoryMatchSelect(wxCommandEvent& event) {
+    int value = m_historyMatchesList->GetSelection();
+    if (value == wxNOT_FOUND) {
+        return;
+    }
+    // Changed without a text event, so the matches stay while the user walks through them
+    m_messageField->ChangeValue(m_historyMatchesList->GetString(value));
+}
+
 void MainFrame::OnVoiceChange(wxCommandEvent& event) {
     int value = m_voicesList->GetSelection();
     if (value == wxNOT_FOUND) {
@@ -189,9 +231,24 @@ void MainFrame::OnOutputDeviceChange(wxCommandEvent& event) {
     g_Audio.selectDevice(static_cast<size_t>(value));
 }
 
+void MainFrame::OnRefresh(wxCommandEvent& event) {
+    int selection = m_outputDevicesList->GetSelection();
+    if (selection != wxNOT_FOUND) {
+        m_cliOutputDeviceIndex = selection;
+    }
+    g_Audio.refreshDevicesList();
+    populateDevicesList();
+}
+
 void MainFrame::OnCharEvent(wxKeyEvent& event) {
     if (event.GetKeyCode() == WXK_ESCAPE) {
         Close();
+    } else if (event.GetKeyCode() == WXK_F8) {
+        // Jobs are cancelled first, so only a chunk being synthesized right now can still be queued after the stop
+        m_speechWorker->cancelAll();
+        g_Audio.stop();
+    } else if (event.GetKeyCode() == WXK_F9) {
+        g_LatencyTracker.logStatistics();
     } else {
         event.Skip();
     }
@@ -206,25 +263,16 @@ void MainFrame::OnHelpButton(wxCommandEvent& event) {
 }
 
 bool MyApp::OnInit() {
-    CLI::App cliApp{"SIM - Speak Instead of Me speech utility"};
-    auto argv = cliApp.ensure_utf8(MyApp::argv);
-    bool cliIsDebugEnabled = false;
-    cliApp.add_flag("-D,--debug", cliIsDebugEnabled, "Enable the debug logging for release builds");
-    std::string cliVoiceName = "";
-    cliApp.add_option(
-        "-n,--voice-name", cliVoiceName,
-        "Specify SAPI voice name to be selected at program start. If present and found, then voice index is ignored");
-    int cliVoiceIndex = 0;
-    cliApp.add_option("-v,--voice", cliVoiceIndex,
-                      "Specify SAPI voice index to be selected at program start. If voice is selected by name and is "
-                      "successfully found, then this option is ignored.");
-    int cliOutputDeviceIndex = 0;
-    cliApp.add_option("-d,--device", cliOutputDeviceIndex,
-                      "Specify output device number to be selected at program start");
-    CLI11_PARSE(cliApp, MyApp::argc, argv);
-
-    InitializeLogging(MyApp::argc, MyApp::argv, cliIsDebugEnabled);
-    auto* frame = new MainFrame(PROGRAM_TITLE, cliVoiceIndex, cliVoiceName, cliOutputDeviceIndex, cliApp.help());
+    // Options are parsed in main before wxWidgets starts
+    const CliOptions& options = g_CliOptions;
+    ApplyCliOptions(options, MyApp::argc, MyApp::argv);
+    SIM_TRACE_THREAD_NAME("UI");
+    // Only the window navigates the history, so headless runs never load it
+    if (!options.historyFile.empty() && !g_HistoryStorage.openLog(options.historyFile)) {
+        spdlog::warn("History log is unavailable, phrases are kept in memory only");
+    }
+    auto* frame = new MainFrame(PROGRAM_TITLE, options.voiceIndex, options.voiceName, options.outputDeviceIndex,
+                                options.helpText);
     frame->Show(true);
     spdlog::debug("Main window shown");
     return true;
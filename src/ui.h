@@ -1,8 +1,14 @@
 #pragma once
 
+#include "speechWorker.h"
+
+#include <memory>
 #include <wx/event.h>
 #include <wx/wx.h>
 
+wxDECLARE_EVENT(wxEVT_SPEECH_COMPLETED, wxThreadEvent);
+wxDECLARE_EVENT(wxEVT_SPEECH_FAILED, wxThreadEvent);
+
 class MainFrame : public wxFrame {
   public:
     MainFrame(const wxString& title, int cliVoiceIndex = 0, std::string cliVoiceName = "", int cliOutputDeviceIndex = 0,
@@ -11,20 +17,25 @@ class MainFrame : public wxFrame {
   private:
     wxPanel* m_panel;
     wxTextCtrl* m_messageField;
+    wxListBox* m_historyMatchesList;
     wxListBox* m_voicesList;
     wxListBox* m_outputDevicesList;
     wxSlider* m_rateSlider;
     wxSlider* m_volumeSlider;
+    wxButton* m_refreshDevicesButton;
     wxButton* m_helpButton;
     int m_cliVoiceIndex = 0;
     std::string m_cliVoiceName;
     int m_cliOutputDeviceIndex = 0;
     std::string m_helpText;
+    std::unique_ptr<SpeechWorker> m_speechWorker;
 
     void populateVoicesList();
     void populateDevicesList();
     void OnEnterPress(wxCommandEvent& event);
     void OnMessageFieldKeyDown(wxKeyEvent& event);
+    void OnMessageFieldTextChange(wxCommandEvent& event);
+    void OnHistoryMatchSelect(wxCommandEvent& event);
     void OnVoiceChange(wxCommandEvent& event);
     void OnOutputDeviceChange(wxCommandEvent& event);
     void OnRateSliderChange(wxCommandEvent& event);
@@ -32,6 +43,8 @@ class MainFrame : public wxFrame {
     void OnRefresh(wxCommandEvent& event);
     void OnCharEvent(wxKeyEvent& event);
     void OnHelpButton(wxCommandEvent& event);
+    void OnSpeechCompleted(wxThreadEvent& event);
+    void OnSpeechFailed(wxThreadEvent& event);
 };
 
 class MyApp : public wxApp {
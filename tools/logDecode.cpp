@@ -0,0 +1,163 @@
+// sim_logdecode prints a binary log written with --binary-log as the text sim would have logged, in LOG_FORMAT
+
+#include "binaryLog.h"
+#include "loggerSetup.h"
+#include "mappedFile.h"
+#include "rtLogFormat.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <spdlog/pattern_formatter.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class BinaryLogDecoder {
+  public:
+    BinaryLogDecoder() : m_formatter(LOG_FORMAT) {}
+
+    // Returns false if the file is not a binary log, a torn tail only ends the output early
+    bool decode(const uint8_t* pData, size_t size) {
+        if (size < sizeof(BINARY_LOG_MAGIC) || std::memcmp(pData, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) != 0) {
+            return false;
+        }
+        size_t offset = sizeof(BINARY_LOG_MAGIC);
+        while (offset < size) {
+            BinaryLogRecordHeader header;
+            if (size - offset < sizeof(header)) {
+                break;
+            }
+            std::memcpy(&header, pData + offset, sizeof(header));
+            offset += sizeof(header);
+            if (size - offset < header.bodySize) {
+                break;
+            }
+            decodeRecord(static_cast<BinaryLogRecordType>(header.type), pData + offset, header.bodySize);
+            offset += header.bodySize;
+        }
+        if (offset != size) {
+            std::fprintf(stderr, "The binary log ends with an incomplete record, it was probably not closed\n");
+        }
+        return true;
+    }
+
+  private:
+    spdlog::pattern_formatter m_formatter;
+    // Nodes are stable, so the string arguments can point into them
+    std::unordered_map<uint32_t, std::string> m_formats;
+    std::unordered_map<uint32_t, std::string> m_strings;
+
+    void decodeRecord(BinaryLogRecordType type, const uint8_t* pBody, size_t bodySize) {
+        switch (type) {
+            case BinaryLogRecordType::FormatDefinition:
+            case BinaryLogRecordType::StringDefinition: {
+                BinaryLogDefinition definition;
+                if (bodySize < sizeof(definition)) {
+                    return;
+                }
+                std::memcpy(&definition, pBody, sizeof(definition));
+                auto& definitions = type == BinaryLogRecordType::FormatDefinition ? m_formats : m_strings;
+                definitions[definition.id] =
+                    std::string((const char*)pBody + sizeof(definition), bodySize - sizeof(definition));
+                break;
+            }
+            case BinaryLogRecordType::Message:
+                decodeMessage(pBody, bodySize);
+                break;
+            case BinaryLogRecordType::Dropped: {
+                BinaryLogDropped dropped;
+                if (bodySize < sizeof(dropped)) {
+                    return;
+                }
+                std::memcpy(&dropped, pBody, sizeof(dropped));
+                // The same text the real-time logger logs when there is no binary log
+                const std::array<RtLogArg, 1> args{dropped.count};
+                print(dropped.timeNs, dropped.threadId, spdlog::level::warn,
+                      FormatRtLogMessage("Dropped {} real-time log messages, the rings were full", args));
+                break;
+            }
+            default:
+                // Written by a newer version, its body is skipped
+                break;
+        }
+    }
+
+    void decodeMessage(const uint8_t* pBody, size_t bodySize) {
+        BinaryLogMessage message;
+        if (bodySize < sizeof(message)) {
+            return;
+        }
+        std::memcpy(&message, pBody, sizeof(message));
+        if (message.argCount > RT_LOG_MAX_ARGS ||
+            bodySize < sizeof(message) + message.argCount * sizeof(BinaryLogArg)) {
+            return;
+        }
+        std::array<RtLogArg, RT_LOG_MAX_ARGS> args;
+        for (size_t i = 0; i < message.argCount; ++i) {
+            BinaryLogArg arg;
+            std::memcpy(&arg, pBody + sizeof(message) + i * sizeof(arg), sizeof(arg));
+            switch (static_cast<BinaryLogArgType>(arg.type)) {
+                case BinaryLogArgType::Int64:
+                    args[i] = static_cast<int64_t>(arg.value);
+                    break;
+                case BinaryLogArgType::UInt64:
+                    args[i] = arg.value;
+                    break;
+                case BinaryLogArgType::Double:
+                    args[i] = std::bit_cast<double>(arg.value);
+                    break;
+                case BinaryLogArgType::Bool:
+                    args[i] = arg.value != 0;
+                    break;
+                case BinaryLogArgType::String: {
+                    auto it = m_strings.find(static_cast<uint32_t>(arg.value));
+                    args[i] = it != m_strings.end() ? it->second.c_str() : "(unknown string)";
+                    break;
+                }
+                default:
+                    args[i] = "(unknown argument)";
+                    break;
+            }
+        }
+        auto it = m_formats.find(message.formatId);
+        const std::string text =
+            it != m_formats.end() ? FormatRtLogMessage(it->second, std::span(args.data(), message.argCount))
+                                  : std::string("(unknown format string)");
+        const auto level = static_cast<spdlog::level::level_enum>(std::min<int>(message.level, spdlog::level::off));
+        print(message.timeNs, message.threadId, level, text);
+    }
+
+    void print(int64_t timeNs, uint64_t threadId, spdlog::level::level_enum level, const std::string& text) {
+        const spdlog::log_clock::time_point time(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(timeNs)));
+        spdlog::details::log_msg logMessage(time, spdlog::source_loc{}, "simlogger", level, text);
+        logMessage.thread_id = static_cast<size_t>(threadId);
+        spdlog::memory_buf_t buffer;
+        m_formatter.format(logMessage, buffer);
+        std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: sim_logdecode <binary log>\n");
+        return 2;
+    }
+    auto mapping = MappedFile::open(std::filesystem::path(argv[1]));
+    if (mapping == nullptr) {
+        std::fprintf(stderr, "Unable to read %s\n", argv[1]);
+        return 1;
+    }
+    BinaryLogDecoder decoder;
+    if (!decoder.decode(mapping->data(), mapping->size())) {
+        std::fprintf(stderr, "%s is not a binary log of sim\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}